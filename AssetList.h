@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////////////////
+// AssetList.h
+// - The assets of the game.  Included by Assets.cpp and by the host tools that
+//   build the asset archive.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Assets.h"
+#include "Defines.h"
+
+// Image, palette, and tilemap data, in the order they are loaded.  The first
+// frame waits for the UI palette, whose colors are cycled, and the rest are
+// loaded while the game runs.  Other images come last, so that when they
+// are still in VRAM after a reset, none of their data has to be skipped.
+const Assets::Info kAssetList[] = {
+  // Font and UI palette.
+  { "font.pal", Assets::TYPE_PALETTE, TEXT_PALETTE_INDEX },
+  { "bricks.pal", Assets::TYPE_PALETTE, UI_PALETTE_INDEX },
+  { "font.raw", Assets::TYPE_IMAGE, Assets::IMAGE_FONT },
+
+  // Palette data.
+  { "squares.pal", Assets::TYPE_PALETTE, BLOCKS_PALETTE_INDEX },
+  { "grass.pal", Assets::TYPE_PALETTE, BG_PALETTE_INDEX },
+
+  // Layer data.
+  { "ui_brick.lay", Assets::TYPE_TILEMAP, UI_LAYER_INDEX },
+  { "bg_grass.lay", Assets::TYPE_TILEMAP, BG_LAYER_INDEX },
+
+  // Image data.
+  { "squares.raw", Assets::TYPE_IMAGE, Assets::IMAGE_SQUARES },
+  { "bricks.raw", Assets::TYPE_IMAGE, Assets::IMAGE_BRICKS },
+  { "grass.raw", Assets::TYPE_IMAGE, Assets::IMAGE_GRASS },
+};
+
+#define NUM_ASSETS   (sizeof(kAssetList) / sizeof(kAssetList[0]))
+
+//  Simon Que, 2013 //
@@ -0,0 +1,540 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Assets.cpp
+// - Implements the asset loading functions.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Assets.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "AssetList.h"
+#include "Log.h"
+#include "Video.h"
+
+namespace {
+
+// Compressed assets are read this many bytes at a time.
+#define LZ_INPUT_SIZE      32
+
+// The last ASSET_LZ_WINDOW_SIZE bytes of decompressed output are kept, and
+// written out half of that at a time.
+#define LZ_FLUSH_SIZE      (ASSET_LZ_WINDOW_SIZE / 2)
+
+// The images in VRAM, kept in the reserved memory so that they can be
+// found there after the MCU is reset.
+#define MANIFEST_MAGIC          "FBVM"
+#define MANIFEST_MAGIC_SIZE        4
+#define MANIFEST_MAX_IMAGES        8
+
+struct ManifestImage {
+    uint32_t hash;
+    uint16_t vram_offset;
+    uint16_t size;
+};
+
+struct Manifest {
+    char magic[MANIFEST_MAGIC_SIZE];
+    uint16_t num_images;
+    uint16_t checksum;              // Of the images.
+    ManifestImage images[MANIFEST_MAX_IMAGES];
+};
+
+// What is kept of a pack entry while the rest of the table is read.
+struct LoadStep {
+    uint8_t type;
+    uint8_t index;
+    uint8_t compression;
+    bool in_vram;                   // Already loaded before a reset.
+    uint16_t size;
+    uint16_t stored_size;
+    uint16_t vram_offset;
+};
+
+uint16_t getChecksum(const Manifest& manifest) {
+    uint16_t sum = manifest.num_images;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(manifest.images);
+    for (uint16_t i = 0; i < manifest.num_images * sizeof(ManifestImage); ++i)
+        sum = (sum << 1 | sum >> 15) + data[i];
+    return sum;
+}
+
+// Reads the manifest.  After power-up, the reserved memory holds no valid
+// manifest, and an empty one is returned.
+void readManifest(Manifest* manifest) {
+    Video::ReadReserved(0, manifest, sizeof(*manifest));
+    if (memcmp(manifest->magic, MANIFEST_MAGIC, MANIFEST_MAGIC_SIZE) != 0 ||
+        manifest->num_images > MANIFEST_MAX_IMAGES ||
+        manifest->checksum != getChecksum(*manifest)) {
+        manifest->num_images = 0;
+    }
+}
+
+void writeManifest(Manifest* manifest) {
+    memcpy(manifest->magic, MANIFEST_MAGIC, MANIFEST_MAGIC_SIZE);
+    manifest->checksum = getChecksum(*manifest);
+    Video::WriteReserved(0, manifest,
+                         offsetof(Manifest, images) +
+                         manifest->num_images * sizeof(ManifestImage));
+}
+
+// Must be called before VRAM is written, so that a reset during loading does
+// not leave a manifest of images that were partly overwritten.
+void clearManifest() {
+    uint8_t header[offsetof(Manifest, images)];
+    memset(header, 0, sizeof(header));
+    Video::WriteReserved(0, header, sizeof(header));
+}
+
+bool isInManifest(const Manifest& manifest, const Assets::PackEntry& entry) {
+    for (int i = 0; i < manifest.num_images; ++i) {
+        const ManifestImage& image = manifest.images[i];
+        if (image.hash == entry.hash && image.vram_offset == entry.vram_offset &&
+            image.size == entry.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Compressed data of an asset, read from the file as it is needed.
+struct LzInput {
+    uint16_t handle;
+    uint16_t remaining;             // Not yet read from the file.
+    uint8_t buffer[LZ_INPUT_SIZE];
+    uint8_t pos;
+    uint8_t size;
+};
+
+bool readByte(LzInput* input, uint8_t* value) {
+    if (input->pos == input->size) {
+        if (!input->remaining)
+            return false;
+        uint16_t size = input->remaining;
+        if (size > LZ_INPUT_SIZE)
+            size = LZ_INPUT_SIZE;
+        if (Video::ReadFile(input->handle, input->buffer, size) != size)
+            return false;
+        input->remaining -= size;
+        input->pos = 0;
+        input->size = size;
+    }
+    *value = input->buffer[input->pos++];
+    return true;
+}
+
+// Writes decompressed data at |offset| bytes into an asset.
+void writeAsset(const LoadStep& step, uint16_t offset, const uint8_t* data,
+                uint16_t size) {
+    switch (step.type) {
+    case Assets::TYPE_TILEMAP:
+        Video::WriteTilemap(step.index, offset, data, size);
+        break;
+    case Assets::TYPE_PALETTE:
+        Video::WritePalette(step.index, offset / sizeof(Video::Color),
+                            reinterpret_cast<const Video::Color*>(data),
+                            size / sizeof(Video::Color));
+        break;
+    case Assets::TYPE_IMAGE:
+        Video::WriteImage(step.vram_offset + offset, data, size);
+        break;
+    }
+}
+
+// Decompressed output of an asset.  Each completed half of the window is
+// written out before it is overwritten.
+struct LzOutput {
+    const LoadStep* step;
+    uint16_t size;                  // Bytes decompressed so far.
+    uint8_t window[ASSET_LZ_WINDOW_SIZE];
+};
+
+void putByte(LzOutput* output, uint8_t value) {
+    output->window[output->size % ASSET_LZ_WINDOW_SIZE] = value;
+    if (++output->size % LZ_FLUSH_SIZE == 0) {
+        uint16_t offset = output->size - LZ_FLUSH_SIZE;
+        writeAsset(*output->step, offset,
+                   output->window + offset % ASSET_LZ_WINDOW_SIZE,
+                   LZ_FLUSH_SIZE);
+    }
+}
+
+// Sizes that a compressed asset may have.  Only images are checked by the
+// Video functions that compressed assets are written with.
+bool isValidCompressedSize(const LoadStep& step) {
+    switch (step.type) {
+    case Assets::TYPE_TILEMAP:
+        return step.size <= TILEMAP_WIDTH * TILEMAP_HEIGHT * sizeof(uint16_t);
+    case Assets::TYPE_PALETTE:
+        return step.size <= PALETTE_NUM_COLORS * sizeof(Video::Color) &&
+               step.size % sizeof(Video::Color) == 0;
+    case Assets::TYPE_IMAGE:
+        return step.vram_offset % IMAGE_BANK_SIZE + (uint32_t)step.size <=
+               IMAGE_BANK_SIZE &&
+               step.vram_offset + (uint32_t)step.size <= IMAGE_VRAM_END;
+    }
+    return false;
+}
+
+// Where decompression of an asset stopped.  A match may be split between
+// calls.
+struct LzState {
+    LzInput input;
+    LzOutput output;
+    uint8_t flags;
+    uint8_t num_items;              // Items read since the flag byte.
+    uint16_t match_distance;
+    uint16_t match_length;          // Bytes of the match not yet copied.
+};
+
+void startCompressedAsset(LzState* lz, uint16_t handle, const LoadStep& step) {
+    lz->input.handle = handle;
+    lz->input.remaining = step.stored_size;
+    lz->input.pos = 0;
+    lz->input.size = 0;
+    lz->output.step = &step;
+    lz->output.size = 0;
+    lz->num_items = 8;
+    lz->match_length = 0;
+}
+
+// Decompresses up to |max_bytes| more bytes of an asset into the core,
+// through a window of memory that is much smaller than the asset.  Returns
+// false if the data is bad.
+bool readCompressedAsset(LzState* lz, const LoadStep& step, uint16_t max_bytes) {
+    LzOutput& output = lz->output;
+    uint16_t end = step.size;
+    if (end - output.size > max_bytes)
+        end = output.size + max_bytes;
+
+    while (output.size < end) {
+        if (lz->match_length) {
+            putByte(&output, output.window[(output.size - lz->match_distance) %
+                                           ASSET_LZ_WINDOW_SIZE]);
+            --lz->match_length;
+            continue;
+        }
+
+        if (lz->num_items == 8) {
+            if (!readByte(&lz->input, &lz->flags))
+                return false;
+            lz->num_items = 0;
+        }
+
+        uint8_t value;
+        if (!readByte(&lz->input, &value))
+            return false;
+        if (lz->flags & (1 << lz->num_items)) {
+            uint8_t length_value;
+            if (!readByte(&lz->input, &length_value))
+                return false;
+            lz->match_distance = value + 1;
+            lz->match_length = length_value + ASSET_LZ_MIN_MATCH;
+            if (lz->match_distance > output.size ||
+                lz->match_length > step.size - output.size) {
+                return false;
+            }
+        } else {
+            putByte(&output, value);
+        }
+        ++lz->num_items;
+    }
+    if (output.size < step.size)
+        return true;
+
+    // Write what is left of the last half window.
+    uint16_t remainder = output.size % LZ_FLUSH_SIZE;
+    if (remainder) {
+        uint16_t offset = output.size - remainder;
+        writeAsset(step, offset, output.window + offset % ASSET_LZ_WINDOW_SIZE,
+                   remainder);
+    }
+    return lz->input.remaining == 0 && lz->input.pos == lz->input.size;
+}
+
+enum LoaderState {
+    LOADER_PACK,                    // Reading the archive.
+    LOADER_FILES,                   // Reading separate files.
+    LOADER_DONE,
+};
+
+// Loading that StartLoading() began.  This stays in memory between frames.
+struct Loader {
+    uint8_t state;
+    bool writes_vram;               // Not all images were kept in VRAM.
+    uint16_t handle;                // Of the archive.
+    uint8_t num_steps;
+    uint8_t step;                   // Next pack entry or kAssetList entry.
+    uint16_t step_loaded;           // Bytes of that asset loaded so far.
+    uint16_t skip_size;             // Archive data to skip before it.
+    uint8_t loaded[Assets::NUM_TYPES];  // One bit per index.
+    uint16_t image_offsets[Assets::NUM_IMAGES];
+};
+
+// What loading from the archive needs until it is done.  The table is only
+// read at the start, before any asset is decompressed.
+struct LoadScratch {
+    LoadStep steps[ASSET_PACK_MAX_ENTRIES];
+    Manifest manifest;              // Of the images in the archive.
+    union {
+        struct {
+            Manifest old_manifest;  // Of the images from before a reset.
+            Assets::PackEntry entry;
+        } table;
+        LzState lz;
+    };
+};
+
+// Once loading is done, the screen keeps its blocks layer state here.
+union LoadMemory {
+    LoadScratch scratch;
+    uint8_t freed[ASSET_FREED_MEMORY_SIZE];
+};
+
+Loader g_loader;
+LoadMemory g_memory;
+
+void setLoaded(uint8_t type, uint8_t index) {
+    if (type < Assets::NUM_TYPES && index < 8)
+        g_loader.loaded[type] |= (1 << index);
+}
+
+// Loads up to |max_bytes| more of an asset from the archive.  Tilemaps and
+// palettes are small, and are read whole.  Returns false if the asset could
+// not be read.
+bool readAsset(const LoadStep& step, uint16_t max_bytes) {
+    Loader& loader = g_loader;
+    LzState& lz = g_memory.scratch.lz;
+    if (step.compression == Assets::COMPRESSION_LZ) {
+        if (loader.step_loaded == 0) {
+            if (!isValidCompressedSize(step))
+                return false;
+            startCompressedAsset(&lz, loader.handle, step);
+        }
+        bool result = readCompressedAsset(&lz, step, max_bytes);
+        loader.step_loaded = lz.output.size;
+        return result;
+    }
+    if (step.compression != Assets::COMPRESSION_NONE)
+        return false;
+
+    uint16_t size = step.size;
+    bool result = false;
+    switch (step.type) {
+    case Assets::TYPE_TILEMAP:
+        result = Video::ReadFileToTilemap(loader.handle, step.index, size);
+        break;
+    case Assets::TYPE_PALETTE:
+        result = Video::ReadFileToPalette(loader.handle, step.index, size);
+        break;
+    case Assets::TYPE_IMAGE:
+        size -= loader.step_loaded;
+        if (size > max_bytes)
+            size = max_bytes;
+        result = Video::ReadFileToImage(loader.handle,
+                                        step.vram_offset + loader.step_loaded,
+                                        size);
+        break;
+    }
+    loader.step_loaded += size;
+    return result;
+}
+
+// Opens the archive and reads its table.  Returns false if there is no usable
+// archive.
+bool startPack() {
+    Loader& loader = g_loader;
+    LoadScratch& scratch = g_memory.scratch;
+    uint16_t size;
+    loader.handle = Video::OpenFile(ASSET_PACK_FILENAME, &size);
+    if (!loader.handle)
+        return false;
+
+    Assets::PackHeader header;
+    if (Video::ReadFile(loader.handle, &header, sizeof(header)) !=
+            sizeof(header) ||
+        memcmp(header.magic, ASSET_PACK_MAGIC, ASSET_PACK_MAGIC_SIZE) != 0 ||
+        header.version != ASSET_PACK_VERSION ||
+        header.num_entries > ASSET_PACK_MAX_ENTRIES) {
+        Log::Write(Log::EVENT_BAD_ASSET_PACK);
+        Video::CloseFile(loader.handle);
+        return false;
+    }
+
+    readManifest(&scratch.table.old_manifest);
+    scratch.manifest.num_images = 0;
+
+    // The data follows the whole table, so the table is read first.  Only
+    // images are kept from before a reset.  The game changes tilemaps and
+    // palettes as it runs.
+    Assets::PackEntry& entry = scratch.table.entry;
+    for (int i = 0; i < header.num_entries; ++i) {
+        if (Video::ReadFile(loader.handle, &entry, sizeof(entry)) !=
+            sizeof(entry)) {
+            Log::Write(Log::EVENT_ASSET_PACK_READ_FAILED, i);
+            Video::CloseFile(loader.handle);
+            return false;
+        }
+        LoadStep& step = scratch.steps[i];
+        step.type = entry.type;
+        step.index = entry.index;
+        step.compression = entry.compression;
+        step.size = entry.size;
+        step.stored_size = entry.stored_size;
+        step.vram_offset = entry.vram_offset;
+        step.in_vram = false;
+        if (entry.type != Assets::TYPE_IMAGE)
+            continue;
+
+        step.in_vram = isInManifest(scratch.table.old_manifest, entry);
+        loader.writes_vram |= !step.in_vram;
+        if (scratch.manifest.num_images < MANIFEST_MAX_IMAGES) {
+            ManifestImage& image =
+                scratch.manifest.images[scratch.manifest.num_images++];
+            image.hash = entry.hash;
+            image.vram_offset = entry.vram_offset;
+            image.size = entry.size;
+        }
+    }
+    loader.num_steps = header.num_entries;
+
+    if (loader.writes_vram)
+        clearManifest();
+    return true;
+}
+
+// Loads the rest from separate files after the archive could not be read.
+// Their images go after the ones in VRAM, and are not in the manifest.
+void stopPack() {
+    Log::Write(Log::EVENT_ASSET_PACK_READ_FAILED, g_loader.step);
+    Video::CloseFile(g_loader.handle);
+    clearManifest();
+    g_loader.state = LOADER_FILES;
+    g_loader.step = 0;
+}
+
+// Loads up to |max_bytes| from the archive.  Returns the number of bytes
+// loaded or skipped.  Tilemaps and palettes are read whole, and are left for
+// the next call if they don't fit, unless |is_first| is set.
+uint16_t loadFromPack(uint16_t max_bytes, bool is_first) {
+    Loader& loader = g_loader;
+    if (loader.step == loader.num_steps) {
+        Video::CloseFile(loader.handle);
+        if (loader.writes_vram)
+            writeManifest(&g_memory.scratch.manifest);
+        loader.state = LOADER_DONE;
+        return 0;
+    }
+
+    const LoadStep& step = g_memory.scratch.steps[loader.step];
+    uint16_t size = 0;
+    if (step.in_vram) {
+        // Data of images that are kept is only skipped when a later asset is
+        // read.
+        loader.skip_size += step.stored_size;
+        Video::KeepImage(step.vram_offset, step.size);
+    } else if (loader.skip_size) {
+        size = loader.skip_size;
+        if (size > max_bytes)
+            size = max_bytes;
+        if (!Video::SkipFile(loader.handle, size)) {
+            stopPack();
+            return max_bytes;
+        }
+        loader.skip_size -= size;
+        return size;
+    } else {
+        if (!is_first && step.compression == Assets::COMPRESSION_NONE &&
+            step.type != Assets::TYPE_IMAGE && step.size > max_bytes) {
+            return max_bytes;
+        }
+        uint16_t loaded = loader.step_loaded;
+        if (!readAsset(step, max_bytes)) {
+            stopPack();
+            return max_bytes;
+        }
+        size = loader.step_loaded - loaded;
+        if (loader.step_loaded < step.size)
+            return size;
+    }
+
+    setLoaded(step.type, step.index);
+    if (step.type == Assets::TYPE_IMAGE && step.index < Assets::NUM_IMAGES)
+        loader.image_offsets[step.index] = step.vram_offset;
+    ++loader.step;
+    loader.step_loaded = 0;
+    return size;
+}
+
+// Loads the next asset that is not loaded yet from its own file.
+void loadFromFiles() {
+    Loader& loader = g_loader;
+    while (loader.step < NUM_ASSETS) {
+        const Assets::Info& asset = kAssetList[loader.step++];
+        if (Assets::IsLoaded((Assets::Type)asset.type, asset.index))
+            continue;
+
+        bool result = false;
+        switch (asset.type) {
+        case Assets::TYPE_TILEMAP:
+            result = Video::LoadTilemap(asset.index, asset.filename);
+            break;
+        case Assets::TYPE_PALETTE:
+            result = Video::LoadPalette(asset.index, asset.filename);
+            break;
+        case Assets::TYPE_IMAGE:
+            result = asset.index < Assets::NUM_IMAGES &&
+                     Video::LoadImage(asset.filename,
+                                      &loader.image_offsets[asset.index]);
+            break;
+        }
+        if (result)
+            setLoaded(asset.type, asset.index);
+        return;
+    }
+    loader.state = LOADER_DONE;
+}
+
+}  // namespace
+
+namespace Assets {
+
+    void StartLoading() {
+        memset(&g_loader, 0, sizeof(g_loader));
+        g_loader.state = LOADER_PACK;
+        if (!startPack()) {
+            // The images loaded from separate files are not in the manifest.
+            clearManifest();
+            g_loader.state = LOADER_FILES;
+        }
+    }
+
+    bool LoadMore(uint16_t max_bytes) {
+        uint16_t budget = max_bytes;
+        while (max_bytes > 0 && g_loader.state != LOADER_DONE) {
+            if (g_loader.state == LOADER_FILES) {
+                loadFromFiles();
+                break;
+            }
+            uint16_t size = loadFromPack(max_bytes, max_bytes == budget);
+            max_bytes -= (size < max_bytes) ? size : max_bytes;
+        }
+        return g_loader.state == LOADER_DONE;
+    }
+
+    void* GetFreedMemory() {
+        return (g_loader.state == LOADER_DONE) ? g_memory.freed : NULL;
+    }
+
+    bool IsLoaded(Type type, uint8_t index) {
+        return type < NUM_TYPES && index < 8 &&
+               (g_loader.loaded[type] & (1 << index));
+    }
+
+    uint16_t GetImageOffset(Image image) {
+        return (image < NUM_IMAGES) ? g_loader.image_offsets[image] : 0;
+    }
+
+}  // namespace Assets
+
+//  Simon Que, 2013 //
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Assets.h
+// - Loads the tilemaps, palettes and images of the game, and defines the
+//   packed asset archive they can be loaded from.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+// Archive of all assets, built by tools/PackAssets.cpp.  It starts with a
+// PackHeader and a PackEntry for each asset, followed by the asset data in
+// the same order.  All values are little endian.
+#define ASSET_PACK_FILENAME     "assets.pak"
+#define ASSET_PACK_MAGIC        "FBPK"
+#define ASSET_PACK_MAGIC_SIZE      4
+#define ASSET_PACK_VERSION         2
+#define ASSET_PACK_MAX_ENTRIES    16
+
+// Compressed assets are LZ77 coded.  Each flag byte is followed by eight
+// items, one per bit from the lowest.  A clear bit is a literal byte.  A set
+// bit is a match of two bytes, the distance minus one and the length minus
+// ASSET_LZ_MIN_MATCH, copied from the last ASSET_LZ_WINDOW_SIZE bytes of
+// output.  The data ends after the last item, so the last flag byte may have
+// unused bits.
+#define ASSET_LZ_WINDOW_SIZE     256
+#define ASSET_LZ_MIN_MATCH         3
+#define ASSET_LZ_MAX_MATCH       (ASSET_LZ_MIN_MATCH + 255)
+
+// Asset names are 8.3 file names, padded with zeroes.
+#define ASSET_NAME_SIZE           12
+
+// Bytes of the memory that loading uses until it is done, which can then be
+// used for something else.  See GetFreedMemory().
+#define ASSET_FREED_MEMORY_SIZE  512
+
+namespace Assets {
+
+    enum Type {
+        TYPE_TILEMAP,
+        TYPE_PALETTE,
+        TYPE_IMAGE,
+        NUM_TYPES,
+    };
+
+    enum Compression {
+        COMPRESSION_NONE,
+        COMPRESSION_LZ,
+    };
+
+    // Images that the screen needs the VRAM offsets of.
+    enum Image {
+        IMAGE_FONT,
+        IMAGE_SQUARES,
+        IMAGE_BRICKS,
+        IMAGE_GRASS,
+        NUM_IMAGES,
+    };
+
+    // An asset, and where it goes.  |index| is the layer of a tilemap, the
+    // palette index of a palette, or the Image of an image.
+    struct Info {
+        const char* filename;
+        uint8_t type;
+        uint8_t index;
+    };
+
+    struct PackHeader {
+        char magic[ASSET_PACK_MAGIC_SIZE];
+        uint16_t num_entries;
+        uint16_t version;
+    };
+
+    struct PackEntry {
+        char name[ASSET_NAME_SIZE];
+        uint8_t type;
+        uint8_t index;
+        uint16_t size;
+        uint16_t vram_offset;       // Where an image goes.  Zero otherwise.
+        uint16_t stored_size;       // Size in the archive.
+        uint8_t compression;
+        uint8_t unused;
+        uint32_t hash;              // FNV-1a hash of the uncompressed data.
+    };
+
+    // Assets are loaded from the archive if there is one and from separate
+    // files if not, a piece at a time in the order of kAssetList, so that
+    // frames are drawn while they load.  StartLoading() reads the archive's
+    // table.  Each LoadMore() call then loads about |max_bytes| of asset
+    // data, or one separate file, and returns true once all assets are done.
+    //
+    // Images from the archive are listed in the reserved memory.  After
+    // the MCU is reset, images that are still in VRAM where the archive puts
+    // them are not read again.
+    void StartLoading();
+    bool LoadMore(uint16_t max_bytes);
+
+    // Returns ASSET_FREED_MEMORY_SIZE bytes of the memory that loading used,
+    // once LoadMore() has returned true, or NULL while loading is not done.
+    // It is used by loading again after the next StartLoading().
+    void* GetFreedMemory();
+
+    // Returns true if an asset has been loaded.  |index| is as in Info.
+    bool IsLoaded(Type type, uint8_t index);
+
+    // VRAM offset of a loaded image.
+    uint16_t GetImageOffset(Image image);
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Bitboard.cpp
+// - Implements the row-mask game field and the block shape table.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Bitboard.h"
+
+#include <stddef.h>
+
+namespace {
+
+// Orientations of each block type, in the order produced by repeatedly calling
+// cBlock::Rotate() on the layouts in cBlock::SetupSquares().  Orientations that
+// look the same are only listed once.
+const BlockShape kSquareShapes[] = {
+    { { 0x3, 0x3, 0x0, 0x0 }, 2, 2 },
+};
+const BlockShape kTShapes[] = {
+    { { 0x7, 0x2, 0x0, 0x0 }, 3, 2 },
+    { { 0x1, 0x3, 0x1, 0x0 }, 2, 3 },
+    { { 0x2, 0x7, 0x0, 0x0 }, 3, 2 },
+    { { 0x2, 0x3, 0x2, 0x0 }, 2, 3 },
+};
+const BlockShape kLShapes[] = {
+    { { 0x3, 0x1, 0x1, 0x0 }, 2, 3 },
+    { { 0x1, 0x7, 0x0, 0x0 }, 3, 2 },
+    { { 0x2, 0x2, 0x3, 0x0 }, 2, 3 },
+    { { 0x7, 0x4, 0x0, 0x0 }, 3, 2 },
+};
+const BlockShape kBackwardsLShapes[] = {
+    { { 0x3, 0x2, 0x2, 0x0 }, 2, 3 },
+    { { 0x7, 0x1, 0x0, 0x0 }, 3, 2 },
+    { { 0x1, 0x1, 0x3, 0x0 }, 2, 3 },
+    { { 0x4, 0x7, 0x0, 0x0 }, 3, 2 },
+};
+const BlockShape kStraightShapes[] = {
+    { { 0x1, 0x1, 0x1, 0x1 }, 1, 4 },
+    { { 0xf, 0x0, 0x0, 0x0 }, 4, 1 },
+};
+const BlockShape kSShapes[] = {
+    { { 0x3, 0x6, 0x0, 0x0 }, 3, 2 },
+    { { 0x2, 0x3, 0x1, 0x0 }, 2, 3 },
+};
+const BlockShape kBackwardsSShapes[] = {
+    { { 0x6, 0x3, 0x0, 0x0 }, 3, 2 },
+    { { 0x1, 0x3, 0x2, 0x0 }, 2, 3 },
+};
+
+#define ARRAY_SIZE(x)  (sizeof(x) / sizeof((x)[0]))
+
+struct ShapeList {
+    const BlockShape* shapes;
+    int num_shapes;
+};
+
+// Indexed by BlockType.
+const ShapeList kShapeLists[] = {
+    { NULL, 0 },                                          // NO_BLOCK
+    { kSquareShapes, ARRAY_SIZE(kSquareShapes) },         // SQUARE_BLOCK
+    { kTShapes, ARRAY_SIZE(kTShapes) },                   // T_BLOCK
+    { kLShapes, ARRAY_SIZE(kLShapes) },                   // L_BLOCK
+    { kBackwardsLShapes, ARRAY_SIZE(kBackwardsLShapes) }, // BACKWARDS_L_BLOCK
+    { kStraightShapes, ARRAY_SIZE(kStraightShapes) },     // STRAIGHT_BLOCK
+    { kSShapes, ARRAY_SIZE(kSShapes) },                   // S_BLOCK
+    { kBackwardsSShapes, ARRAY_SIZE(kBackwardsSShapes) }, // BACKWARDS_S_BLOCK
+};
+
+bool Fits(const Bitboard& board, const BlockShape& shape, int x, int y) {
+    for (int i = 0; i < shape.height; ++i) {
+        if (board.rows[y + i] & (shape.rows[i] << x))
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+void Bitboard::Clear() {
+    for (int y = 0; y < MAX_NUM_LINES; ++y)
+        rows[y] = 0;
+}
+
+bool Bitboard::Empty() const {
+    for (int y = 0; y < MAX_NUM_LINES; ++y) {
+        if (rows[y])
+            return false;
+    }
+    return true;
+}
+
+int Bitboard::CountSquares() const {
+    int count = 0;
+    for (int y = 0; y < MAX_NUM_LINES; ++y)
+        count += CountBits(rows[y]);
+    return count;
+}
+
+int Bitboard::ClearFullRows() {
+    int num_lines = 0;
+    int dest = 0;
+    for (int y = 0; y < MAX_NUM_LINES; ++y) {
+        if (rows[y] == FULL_ROW_MASK) {
+            ++num_lines;
+            continue;
+        }
+        rows[dest++] = rows[y];
+    }
+    while (dest < MAX_NUM_LINES)
+        rows[dest++] = 0;
+    return num_lines;
+}
+
+uint64_t Bitboard::Hash() const {
+    // FNV-1a over the row masks.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int y = 0; y < MAX_NUM_LINES; ++y) {
+        hash ^= rows[y];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+int Bitboard::DropBlock(int type, int rotation, int x) {
+    const BlockShape& shape = GetBlockShape(type, rotation);
+    if (x < 0 || x + shape.width > SQUARES_PER_ROW)
+        return -1;
+
+    // Start at the top and slide down until the block lands.
+    int y = MAX_NUM_LINES - shape.height;
+    if (!Fits(*this, shape, x, y))
+        return -1;
+    while (y > 0 && Fits(*this, shape, x, y - 1))
+        --y;
+
+    for (int i = 0; i < shape.height; ++i)
+        rows[y + i] |= shape.rows[i] << x;
+    return y;
+}
+
+int GetNumRotations(int type) {
+    return kShapeLists[type].num_shapes;
+}
+
+const BlockShape& GetBlockShape(int type, int rotation) {
+    return kShapeLists[type].shapes[rotation];
+}
+
+int CountBits(RowMask mask) {
+    int count = 0;
+    while (mask) {
+        mask &= mask - 1;
+        ++count;
+    }
+    return count;
+}
+
+//  Simon Que, 2013 //
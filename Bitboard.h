@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Bitboard.h
+// - Row-mask representation of the game field and of the block shapes.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Defines.h"
+#include "Enums.h"
+
+// One bit per column of the game area.  Bit 0 is the leftmost column.
+typedef uint16_t RowMask;
+
+#define FULL_ROW_MASK      ((RowMask)((1 << SQUARES_PER_ROW) - 1))
+
+// Number of block types, not counting NO_BLOCK.
+#define NUM_BLOCK_TYPES    7
+
+// Maximum number of distinct orientations of a block.
+#define NUM_ROTATIONS      4
+
+// The game field as one row mask per line.  Rows are stored bottom-up, so
+// rows[0] is the bottom line of the game area, the same order LandedSquares
+// uses for its rows.
+struct Bitboard {
+    RowMask rows[MAX_NUM_LINES];
+
+    // Empty the board.
+    void Clear();
+
+    bool Get(int x, int y) const {
+        return (rows[y] >> x) & 1;
+    }
+    void Set(int x, int y) {
+        rows[y] |= (RowMask)(1 << x);
+    }
+
+    bool Empty() const;
+
+    // Number of occupied cells.
+    int CountSquares() const;
+
+    // Remove full rows and drop the rows above them.  Returns the number of
+    // rows removed.
+    int ClearFullRows();
+
+    // 64-bit hash of the board contents.
+    uint64_t Hash() const;
+
+    // Drop orientation |rotation| of |type| straight down from the top of the
+    // game area with its left edge at column |x|, and add its squares.
+    // Returns the row of its bottom edge, or -1 if it does not fit.
+    int DropBlock(int type, int rotation, int x);
+};
+
+// The cells of one orientation of a block, bottom-up and shifted so that its
+// lowest row and leftmost column are both at zero.
+struct BlockShape {
+    RowMask rows[4];
+    int8_t width;
+    int8_t height;
+};
+
+// One block dropped in one orientation.
+struct Placement {
+    uint8_t type;
+    uint8_t rotation;   // Index for GetBlockShape().
+    int8_t x;           // Column of the left edge of the shape.
+    int8_t y;           // Row of the bottom edge of the shape after landing.
+};
+
+// Returns the number of distinct orientations of a block type.
+int GetNumRotations(int type);
+
+// Returns one orientation of a block type.  |rotation| must be less than
+// GetNumRotations(type).  Orientations follow the clockwise order used by
+// cBlock::Rotate().
+const BlockShape& GetBlockShape(int type, int rotation);
+
+// Number of set bits in a row mask.
+int CountBits(RowMask mask);
+
+//  Simon Que, 2013 //
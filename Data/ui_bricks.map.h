@@ -2,25 +2,36 @@
 #include <avr/pgmspace.h>
 const uint32_t ui_bricks_tmx_layer0_dat_data32[] PROGMEM = {
 	0x30002,0x30002,0x30002,0x30002,0x30002,0x30002,0x30002,0x30002,
-	0x30002,0x30002,0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,
-	0x20003,0x20003,0x20003,0x20003,0x30002,0x0000,0x0000,0x0000,
-	0x0000,0x0000,0x30002,0x30002,0x30002,0x30002,0x20003,0x0000,
-	0x0000,0x0000,0x0000,0x0000,0x20003,0x20003,0x20003,0x20003,
+	0x30002,0x30002,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x20003,0x20003,
+	0x20003,0x20003,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x30002,0x0000,0x0000,0x0000,0x0000,0x0000,0x30002,0x30002,
+	0x30002,0x30002,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x20003,0x20003,
+	0x20003,0x20003,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
 	0x30003,0x0000,0x0000,0x0000,0x0000,0x0000,0x30002,0x30002,
-	0x30002,0x30002,0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,
-	0x20003,0x20003,0x20003,0x20003,0x30002,0x0000,0x0000,0x0000,
-	0x0000,0x0000,0x30002,0x30002,0x30002,0x30002,0x20003,0x0000,
-	0x0000,0x0000,0x0000,0x0000,0x20003,0x20003,0x20003,0x20003,
+	0x30002,0x30002,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x20003,0x20003,
+	0x20003,0x20003,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x30002,0x0000,0x0000,0x0000,0x0000,0x0000,0x30002,0x30002,
+	0x30002,0x30002,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x20003,0x20003,
+	0x20003,0x20003,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
 	0x30002,0x0000,0x0000,0x0000,0x0000,0x0000,0x30003,0x30002,
-	0x30002,0x30002,0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,
-	0x30002,0x0000,0x0000,0x30000,0x30002,0x0000,0x0000,0x0000,
-	0x0000,0x0000,0x20003,0x0000,0x0000,0x20000,0x20003,0x0000,
-	0x0000,0x0000,0x0000,0x0000,0x30002,0x0000,0x0000,0x30000,
+	0x30002,0x30002,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x30002,0x0000,
+	0x0000,0x30000,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
 	0x30002,0x0000,0x0000,0x0000,0x0000,0x0000,0x20003,0x0000,
-	0x0000,0x20000,0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,
-	0x30002,0x0000,0x0000,0x30000,0x30002,0x30002,0x30002,0x30002,
-	0x30002,0x30002,0x30003,0x30002,0x30002,0x30002,
+	0x0000,0x20000,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x30002,0x0000,
+	0x0000,0x30000,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x30002,0x0000,0x0000,0x0000,0x0000,0x0000,0x20003,0x0000,
+	0x0000,0x20000,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x20003,0x0000,0x0000,0x0000,0x0000,0x0000,0x30002,0x0000,
+	0x0000,0x30000,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
+	0x30002,0x30002,0x30002,0x30002,0x30002,0x30002,0x30003,0x30002,
+	0x30002,0x30002,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,0x1fff1fff,
 };
 uint8_t* ui_bricks_tmx_layer0_dat_data8 = (uint8_t*) ui_bricks_tmx_layer0_dat_data32;
 uint16_t* ui_bricks_tmx_layer0_dat_data16 = (uint16_t*) ui_bricks_tmx_layer0_dat_data32;
-const int UI_BRICKS_TMX_LAYER0_DAT_DATA_SIZE = 600;
+const int UI_BRICKS_TMX_LAYER0_DAT_DATA_SIZE = 960;
@@ -38,6 +38,11 @@
 // Measured in number of frames. At 30 fps, 15 frames will give the player half a second.     //
 #define SLIDE_TIME       15
 
+// Completed lines blink for this many frames before they are cleared.  The  //
+// game is paused meanwhile, and the screen has time to redraw the field.    //
+#define LINE_CLEAR_TIME         12
+#define LINE_CLEAR_BLINK_TIME    3  // frames between blinks
+
 #define SQUARES_PER_ROW  GAME_AREA_WIDTH  // number of squares that fit in a row
 #define SQUARE_MEDIAN     8  // distance from the center of a square to its sides
 #define SQUARE_SIZE    (SQUARE_MEDIAN * 2)   // Width and height of square.
@@ -75,6 +80,7 @@ enum {
   UI_LAYER_INDEX,
   BLOCKS_LAYER_INDEX,
   TEXT_LAYER_INDEX,
+  NUM_TILE_LAYERS,
 };
 
 // Palette indexes.
@@ -23,4 +23,14 @@ enum Direction
     DOWN
 };
 
+// These are used to enumerate the various game state functions.
+enum GameStates {
+    GAME_STATE_EXIT,
+    GAME_STATE_MENU,
+    GAME_STATE_GAME,
+    GAME_STATE_WON,
+    GAME_STATE_LOST,
+    NUM_GAME_STATES,
+};
+
 //  Aaron Cox, 2004 //
@@ -9,21 +9,15 @@
 
 #include "Defines.h" // Our defines header
 #include "Enums.h"   // Our enums header
+#include "Log.h"             // Diagnostic events sent over serial.
+#include "Profile.h"         // Times the phases of each frame.
 #include "System.h"          // Replaces SDL timer and input functions.
 
-// These are used to enumerate the various game state functions.
-enum GameStates {
-    GAME_STATE_EXIT,
-    GAME_STATE_MENU,
-    GAME_STATE_GAME,
-    GAME_STATE_WON,
-    GAME_STATE_LOST,
-};
-
 // This function initializes our game //
 void FallingBlocksGame::Init()
 {
     m_Screen.Init();
+    m_Hud.Invalidate();
 
     // Get the number of ticks since system was initialized //
     m_Timer = System::GetTicks();
@@ -56,6 +50,9 @@ void FallingBlocksGame::MainLoop() {
     // empty.
     while (!m_StateStack.empty())
     {
+        // Show the last frame drawn as soon as blanking starts. //
+        m_Screen.PollFlip();
+
         int state = m_StateStack.top();
         switch(state) {
         case GAME_STATE_EXIT:
@@ -74,9 +71,35 @@ void FallingBlocksGame::MainLoop() {
             GameLost();
             break;
         }
+
+        Idle();
     }
 }
 
+// Sends the log a few bytes each millisecond, prints the frame profile //
+// when asked to over serial, and loads the assets that the first frame //
+// did not need, a chunk at a time.                                     //
+void FallingBlocksGame::Idle()
+{
+    if (System::ReadSerial() == PROFILE_DUMP_REQUEST)
+        Profile::Dump();
+
+    uint32_t ticks = System::GetTicks();
+    if (ticks != m_LogTicks)
+    {
+        m_LogTicks = ticks;
+        uint8_t data[LOG_DRAIN_SIZE];
+        uint16_t size = Log::Read(data, sizeof(data));
+        if (size)
+            System::WriteSerial(data, size);
+    }
+
+    if (m_Screen.AreAssetsLoaded())
+        return;
+    if (ticks - m_Timer + ASSET_LOAD_CHUNK_TIME < FRAME_RATE)
+        m_Screen.LoadAssets();
+}
+
 // This function shuts down our game //
 void FallingBlocksGame::Shutdown()
 {
@@ -98,17 +121,24 @@ void FallingBlocksGame::Menu()
     // handled a frame. If FRAME_RATE amount of time has passed, it's time for a new frame. //
     if ( (System::GetTicks() - m_Timer) >= FRAME_RATE )
     {
+        Profile::StartFrame(GAME_STATE_MENU);
+
         // We start by calling our input function //
         HandleMenuInput();
+        Profile::EndPhase(Profile::PHASE_INPUT);
 
         // Make sure nothing from the last frame is still drawn //
         ClearScreen();
+        Profile::EndPhase(Profile::PHASE_ERASE);
 
         DisplayText("Start (G)ame", 8, 8, 12, 255, 255, 255, 0, 0, 0);
         DisplayText("(Q)uit Game",  8, 9, 12, 255, 255, 255, 0, 0, 0);
+        Profile::EndPhase(Profile::PHASE_DRAW);
 
         // Update video screen.
         m_Screen.Update();
+        Profile::EndPhase(Profile::PHASE_UPDATE);
+        Profile::EndFrame();
 
         // We've processed a frame so we now need to record the time at which we did it. //
         // This way we can compare this time with the next time our function gets called //
@@ -121,101 +151,59 @@ void FallingBlocksGame::Menu()
 // drawing of the game as well as any necessary game logic. //
 void FallingBlocksGame::Game()
 {
-    // Every frame we increase this value until it is equal to m_FocusBlockSpeed. //
-    // When it reaches that value, we force the focus block down. //
-    static int force_down_counter = 0;
-
-    // Every frame, we check to see if the focus block's bottom has hit something. If it    //
-    // has, we decrement this counter. If the counter hits zero, the focus block needs to   //
-    // be changed. We use this counter so the player can slide the block before it changes. //
-    static int slide_counter = SLIDE_TIME;
-
     // Here we compare the difference between the current time and the last time we //
     // handled a frame. If FRAME_RATE amount of time has, it's time for a new frame. //
     if ( (System::GetTicks() - m_Timer) >= FRAME_RATE )
     {
-        HandleGameInput();
+        Profile::StartFrame(GAME_STATE_GAME);
 
-        force_down_counter++;
-
-        if (force_down_counter >= m_FocusBlockSpeed)
+        // The game is drawn from all of the assets.  Until they are loaded, //
+        // Idle() loads them between frames and the game waits.             //
+        if (!m_Screen.AreAssetsLoaded())
         {
-            // Always check for collisions before moving anything //
-            if ( !CheckWallCollisions(m_FocusBlock, DOWN) && !CheckEntityCollisions(m_FocusBlock, DOWN) )
-            {
-                m_FocusBlock.Move(DOWN); // move the focus block
-                force_down_counter = 0;   // reset our counter
-            }
-        }
+            Profile::EndPhase(Profile::PHASE_LOAD);
 
-        // Check to see if focus block's bottom has hit something. If it has, we decrement our counter. //
-        if ( CheckWallCollisions(m_FocusBlock, DOWN) || CheckEntityCollisions(m_FocusBlock, DOWN) )
-        {
-            slide_counter--;
-        }
-        // If there isn't a collision, we reset our counter.    //
-        // This is in case the player moves out of a collision. //
-        else
-        {
-            slide_counter = SLIDE_TIME;
-        }
-        // If the counter hits zero, we reset it and call our //
-        // function that handles changing the focus block.    //
-        if (slide_counter == 0)
-        {
-            slide_counter = SLIDE_TIME;
-            HandleBottomCollision();
+            m_Screen.Update();
+            Profile::EndPhase(Profile::PHASE_UPDATE);
+            Profile::EndFrame();
+            m_Timer = System::GetTicks();
+            return;
         }
+        Profile::EndPhase(Profile::PHASE_LOAD);
 
-        m_Screen.WaitForNoVblank();  // Wait for vertical refresh if applicable.
-        m_Screen.WaitForVblank();
+        System::KeyState key_state = System::GetKeyState();
+        Profile::EndPhase(Profile::PHASE_INPUT);
 
-        // Erase the squares.  They only need to be erased when the focus block
-        // moves or the next block gets updated.  But we don't know when that
-        // will happen (need to erase during blanking).  This doesn't take long.
-        m_OldFocusBlock.Erase(&m_Screen);
-        m_OldNextBlock.Erase(&m_Screen);
+        UpdateGame(key_state);
+
+        // There is no need to wait for vertical refresh.  The blocks are drawn
+        // to a back buffer, which is shown by PollFlip() during blanking.
 
         // Make sure nothing from the last frame is still drawn. //
         ClearScreen();
+        Profile::EndPhase(Profile::PHASE_ERASE);
 
         // Draw the background //
         DrawBackground();
 
-        // Draw the focus block and next block. //
-        m_FocusBlock.Draw(&m_Screen);
-        m_NextBlock.Draw(&m_Screen);
-
-        // Draw the old squares. //
-        m_OldSquares.Draw(&m_Screen);
+        // Draw the focus block, next block and old squares.  Lines that are //
+        // being cleared blink.                                                //
+        uint16_t hidden_lines = 0;
+        if ((m_LineClearCounter / LINE_CLEAR_BLINK_TIME) % 2)
+            hidden_lines = m_ClearingLines;
+        m_Screen.DrawBlocks(&m_OldSquares, hidden_lines, &m_FocusBlock,
+                            &m_NextBlock);
+        Profile::EndPhase(Profile::PHASE_DRAW);
 
-        // Draw the text for the current level, score, and needed score. //
-
-        // We need to display the text ("Score:", "Level:", "Needed Score:") as well as the //
-        // associated value. To do this, we use the string function append(). This function //
-        // takes a char string so we call itoa() and store the char string in temp.         //
-        char string[256];
-
-        sprintf(string, "Level %u", m_Level);
-        DisplayText(string, LEVEL_RECT_X, LEVEL_RECT_Y,
-                    8, 0, 0, 0, 255, 255, 255);
-
-        sprintf(string, "Score:");
-        DisplayText(string, SCORE_RECT_X, SCORE_RECT_Y,
-                    8, 0, 0, 0, 255, 255, 255);
-        sprintf(string, "      %5u", m_Score);
-        DisplayText(string, SCORE_RECT_X, SCORE_RECT_Y + 1,
-                    8, 0, 0, 0, 255, 255, 255);
-
-        sprintf(string, "Next level:");
-        DisplayText(string, NEEDED_SCORE_RECT_X, NEEDED_SCORE_RECT_Y,
-                    8, 0, 0, 0, 255, 255, 255);
-        sprintf(string, "      %5u", m_Level*POINTS_PER_LEVEL);
-        DisplayText(string, NEEDED_SCORE_RECT_X, NEEDED_SCORE_RECT_Y + 1,
-                    8, 0, 0, 0, 255, 255, 255);
+        // Draw the text for the current level, score, and needed score.  Only //
+        // the digits that changed since the last frame are written.          //
+        m_Hud.Draw(&m_Screen, m_Level, m_Score, m_Level*POINTS_PER_LEVEL);
+        Profile::EndPhase(Profile::PHASE_HUD);
 
         // Update video screen.
         m_Screen.Update();
+        Profile::EndPhase(Profile::PHASE_UPDATE);
+        Profile::EndFrame();
 
         // We've processed a frame so we now need to record the time at which we did it. //
         // This way we can compare this time the next time our function gets called and  //
@@ -224,6 +212,60 @@ void FallingBlocksGame::Game()
     }
 }
 
+// Advance the game logic by one frame using the given input.  This does not  //
+// depend on the frame timer, so it can be stepped as fast as the caller likes. //
+void FallingBlocksGame::UpdateGame(const System::KeyState& key_state)
+{
+    // While completed lines blink, nothing else moves. //
+    if (m_LineClearCounter > 0)
+    {
+        if (--m_LineClearCounter == 0)
+            FinishLineClear();
+        Profile::EndPhase(Profile::PHASE_LINE_CLEAR);
+        return;
+    }
+
+    HandleGameInput(key_state);
+    Profile::EndPhase(Profile::PHASE_INPUT);
+
+    // Every frame we increase this value until it is equal to m_FocusBlockSpeed. //
+    // When it reaches that value, we force the focus block down. //
+    m_ForceDownCounter++;
+
+    if (m_ForceDownCounter >= m_FocusBlockSpeed)
+    {
+        // Always check for collisions before moving anything //
+        if ( !CheckWallCollisions(m_FocusBlock, DOWN) && !CheckEntityCollisions(m_FocusBlock, DOWN) )
+        {
+            m_FocusBlock.Move(DOWN); // move the focus block
+            m_ForceDownCounter = 0;  // reset our counter
+        }
+    }
+    Profile::EndPhase(Profile::PHASE_GRAVITY);
+
+    // Every frame, we check to see if the focus block's bottom has hit something. If it    //
+    // has, we decrement this counter. If the counter hits zero, the focus block needs to   //
+    // be changed. We use this counter so the player can slide the block before it changes. //
+    if ( CheckWallCollisions(m_FocusBlock, DOWN) || CheckEntityCollisions(m_FocusBlock, DOWN) )
+    {
+        m_SlideCounter--;
+    }
+    // If there isn't a collision, we reset our counter.    //
+    // This is in case the player moves out of a collision. //
+    else
+    {
+        m_SlideCounter = SLIDE_TIME;
+    }
+    // If the counter hits zero, we reset it and call our //
+    // function that handles changing the focus block.    //
+    if (m_SlideCounter == 0)
+    {
+        m_SlideCounter = SLIDE_TIME;
+        HandleBottomCollision();
+    }
+    Profile::EndPhase(Profile::PHASE_SLIDE);
+}
+
 // This function handles the game's exit screen. It will display //
 // a message asking if the player really wants to quit.          //
 void FallingBlocksGame::Exit()
@@ -232,15 +274,22 @@ void FallingBlocksGame::Exit()
     // handled a frame. If FRAME_RATE amount of time has, it's time for a new frame. //
     if ( (System::GetTicks() - m_Timer) >= FRAME_RATE )
     {
+        Profile::StartFrame(GAME_STATE_EXIT);
+
         HandleExitInput();
+        Profile::EndPhase(Profile::PHASE_INPUT);
 
         // Make sure nothing from the last frame is still drawn. //
         ClearScreen();
+        Profile::EndPhase(Profile::PHASE_ERASE);
 
         DisplayText("Quit Game (Y or N)?", 6, 9, 12, 255, 255, 255, 0, 0, 0);
+        Profile::EndPhase(Profile::PHASE_DRAW);
 
         // Update video screen.
         m_Screen.Update();
+        Profile::EndPhase(Profile::PHASE_UPDATE);
+        Profile::EndFrame();
 
         // We've processed a frame so we now need to record the time at which we did it. //
         // This way we can compare this time the next time our function gets called and  //
@@ -254,15 +303,22 @@ void FallingBlocksGame::GameWon()
 {
     if ( (System::GetTicks() - m_Timer) >= FRAME_RATE )
     {
+        Profile::StartFrame(GAME_STATE_WON);
+
         HandleWinLoseInput();
+        Profile::EndPhase(Profile::PHASE_INPUT);
 
         ClearScreen();
+        Profile::EndPhase(Profile::PHASE_ERASE);
 
         DisplayText("You Win!!!", 6, 8, 12, 255, 255, 255, 0, 0, 0);
         DisplayText("Quit Game (Y or N)?", 6, 9, 12, 255, 255, 255, 0, 0, 0);
+        Profile::EndPhase(Profile::PHASE_DRAW);
 
         // Update video screen.
         m_Screen.Update();
+        Profile::EndPhase(Profile::PHASE_UPDATE);
+        Profile::EndFrame();
 
         m_Timer = System::GetTicks();
     }
@@ -273,15 +329,22 @@ void FallingBlocksGame::GameLost()
 {
     if ( (System::GetTicks() - m_Timer) >= FRAME_RATE )
     {
+        Profile::StartFrame(GAME_STATE_LOST);
+
         HandleWinLoseInput();
+        Profile::EndPhase(Profile::PHASE_INPUT);
 
         ClearScreen();
+        Profile::EndPhase(Profile::PHASE_ERASE);
 
         DisplayText("You Lose.", 6, 8, 12, 255, 255, 255, 0, 0, 0);
         DisplayText("Quit Game (Y or N)?", 6, 9, 12, 255, 255, 255, 0, 0, 0);
+        Profile::EndPhase(Profile::PHASE_DRAW);
 
         // Update video screen.
         m_Screen.Update();
+        Profile::EndPhase(Profile::PHASE_UPDATE);
+        Profile::EndFrame();
 
         m_Timer = System::GetTicks();
     }
@@ -328,11 +391,8 @@ void FallingBlocksGame::HandleMenuInput()
 
 // This function receives player input and //
 // handles it for the main game state.     //
-void FallingBlocksGame::HandleGameInput()
+void FallingBlocksGame::HandleGameInput(const System::KeyState& key_state)
 {
-    // Get state of the input keys.
-    System::KeyState key_state = System::GetKeyState();
-
     if (key_state.quit)
     {
         m_StateStack.pop();
@@ -459,7 +519,7 @@ bool FallingBlocksGame::CheckEntityCollisions(
     }
 
     // Check collision against landed squares //
-    if (m_OldSquares.CheckCollision(x, y, distance))
+    if (m_OldSquares.CheckCollision(x, y))
         return true;
 
     return false;
@@ -525,9 +585,6 @@ bool FallingBlocksGame::CheckRotationCollisions(const cBlock& block)
     int rotated_squares[CBLOCK_NUM_SQUARES * 2];
     block.GetRotatedSquares(rotated_squares);
 
-    // Distance between two touching squares //
-    int distance = SQUARE_SIZE;
-
     for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i)
     {
         // Check to see if the block will go out of bounds //
@@ -544,7 +601,7 @@ bool FallingBlocksGame::CheckRotationCollisions(const cBlock& block)
 
         // Check to see if the block will collide with any squares //
         if (m_OldSquares.CheckCollision(rotated_squares[i*2],
-                                        rotated_squares[i*2+1], distance)) {
+                                        rotated_squares[i*2+1])) {
             return true;
         }
     }
@@ -558,6 +615,22 @@ void FallingBlocksGame::HandleBottomCollision()
 {
     ChangeFocusBlock();
 
+    // If lines were completed, let them blink before clearing them. //
+    m_ClearingLines = m_OldSquares.GetCompletedLines();
+    if (m_ClearingLines)
+    {
+        m_LineClearCounter = LINE_CLEAR_TIME;
+        return;
+    }
+
+    FinishLineClear();
+}
+
+// Clear the completed lines, if any, and score them. //
+void FallingBlocksGame::FinishLineClear()
+{
+    m_ClearingLines = 0;
+
     // Check for completed lines and store the number of lines completed //
     int num_lines = CheckCompletedLines();
 
@@ -590,13 +663,11 @@ void FallingBlocksGame::ChangeFocusBlock()
     for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i)
         m_OldSquares.Add(square_array[i]);
 
-    m_OldFocusBlock = m_FocusBlock;
     m_FocusBlock = m_NextBlock; // set the focus block to the next block
     m_FocusBlock.SetupSquares(BLOCK_START_X * SQUARE_SIZE,
                               BLOCK_START_Y * SQUARE_SIZE);
 
     // Set the next block to a new block of random type //
-    m_OldNextBlock = m_NextBlock;
     m_NextBlock = cBlock(NEXT_BLOCK_CIRCLE_X * SQUARE_SIZE,
                          NEXT_BLOCK_CIRCLE_Y * SQUARE_SIZE, (rand() % 7 + 1));
 }
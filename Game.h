@@ -10,24 +10,30 @@
 
 #include "cBlock.h"  // Contains the class that represents a game block
 
+#include "Hud.h"          // Level and score text.
 #include "StateStack.h"   // Replaces stack<StatePointer>.
 #include "LandedSquares.h"   // Replaces vector<cSquare>.
 #include "Screen.h"          // Replaces SDL video functions.
+#include "System.h"          // Replaces SDL timer and input functions.
 
 // Game object containing all (previously) global game data.
 class FallingBlocksGame {
   private:
     StateStack     m_StateStack;       // Our state stack
     Screen         m_Screen;           // Video screen controller.
+    Hud            m_Hud;              // Level and score text.
     uint32_t       m_Timer;            // Our timer is just an integer
+    uint32_t       m_LogTicks;         // When the log was last sent
     cBlock         m_FocusBlock;       // The block the player is controlling
     cBlock         m_NextBlock;        // The next block to be the focus block
-    cBlock         m_OldFocusBlock;    // The previous focus block.
-    cBlock         m_OldNextBlock;     // The previous next block.
     LandedSquares  m_OldSquares;       // The squares that have landed.
     uint32_t       m_Score;            // Players current score
     int            m_Level;            // Current level player is on
     int            m_FocusBlockSpeed;  // Speed of the focus block
+    int            m_ForceDownCounter; // Frames since the focus block last fell
+    int            m_SlideCounter;     // Frames left before the focus block lands
+    int            m_LineClearCounter; // Frames left in the line clear animation
+    uint16_t       m_ClearingLines;    // Rows being cleared, bit 0 at the bottom
 
     // Used to avoid repeating pressing the up key.
     bool m_up_pressed;
@@ -38,9 +44,14 @@ class FallingBlocksGame {
     bool m_right_pressed;
 
  public:
-    FallingBlocksGame() : m_Score(0),
+    FallingBlocksGame() : m_LogTicks(0),
+                          m_Score(0),
                           m_Level(1),
                           m_FocusBlockSpeed(INITIAL_SPEED),
+                          m_ForceDownCounter(0),
+                          m_SlideCounter(SLIDE_TIME),
+                          m_LineClearCounter(0),
+                          m_ClearingLines(0),
                           m_up_pressed(false),
                           m_down_pressed(false),
                           m_left_pressed(false),
@@ -52,6 +63,9 @@ class FallingBlocksGame {
     void MainLoop();
     void Shutdown();
 
+    // Work done between frames, while there is time before the next one. //
+    void Idle();
+
     // Functions to handle the states of the game //
     void Menu();
     void Game();
@@ -59,13 +73,23 @@ class FallingBlocksGame {
     void GameWon();
     void GameLost();
 
+    // Advances the game state by one frame, without any frame pacing. //
+    void UpdateGame(const System::KeyState& key_state);
+
+    // Accessors for host tools that check the game logic. //
+    const cBlock& GetFocusBlock() const { return m_FocusBlock; }
+    const cBlock& GetNextBlock() const { return m_NextBlock; }
+    const LandedSquares& GetLandedSquares() const { return m_OldSquares; }
+    uint32_t GetScore() const { return m_Score; }
+    bool IsRunning() const { return !m_StateStack.empty(); }
+
     // Helper functions for the main game state functions //
     void DrawBackground();
     void ClearScreen();
     void DisplayText(const char* text, int x, int y, int size,
                      int fR, int fG, int fB, int bR, int bG, int bB);
     void HandleMenuInput();
-    void HandleGameInput();
+    void HandleGameInput(const System::KeyState& key_state);
     void HandleExitInput();
     void HandleWinLoseInput();
     bool CheckEntityCollisions(const cSquare& square, Direction dir);
@@ -76,6 +100,7 @@ class FallingBlocksGame {
     void CheckWin();
     void CheckLoss();
     void HandleBottomCollision();
+    void FinishLineClear();
     void ChangeFocusBlock();
     int CheckCompletedLines();
 };
@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Hud.cpp
+// - Implements functions for class Hud.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Hud.h"
+
+#include "Defines.h"
+#include "Screen.h"
+
+// Places of the HUD fields, in text grid coordinates.  Each value is drawn
+// after its label, as "Level %u" and "      %5u" used to.
+#define LEVEL_VALUE_X          (LEVEL_RECT_X + 5)
+#define LEVEL_VALUE_WIDTH      2
+#define SCORE_VALUE_X          (SCORE_RECT_X + 6)
+#define NEEDED_SCORE_VALUE_X   (NEEDED_SCORE_RECT_X + 6)
+
+namespace {
+
+// Draws text in the HUD color.
+void drawText(Screen* screen, const char* text, int x, int y) {
+    screen->DisplayText(text, x, y, 8, 0, 0, 0, 255, 255, 255);
+}
+
+}  // namespace
+
+void FormatDigits(uint32_t value, char* digits, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        digits[i] = '0' + value % 10;
+        value /= 10;
+        if (value == 0) {
+            while (i > 0)
+                digits[--i] = ' ';
+            break;
+        }
+    }
+}
+
+Hud::Hud() : m_Valid(false) {
+    Field& level = m_Fields[LEVEL_FIELD];
+    level.x = LEVEL_VALUE_X;
+    level.y = LEVEL_RECT_Y;
+    level.width = LEVEL_VALUE_WIDTH;
+
+    Field& score = m_Fields[SCORE_FIELD];
+    score.x = SCORE_VALUE_X;
+    score.y = SCORE_RECT_Y + 1;
+    score.width = HUD_MAX_DIGITS;
+
+    Field& needed_score = m_Fields[NEEDED_SCORE_FIELD];
+    needed_score.x = NEEDED_SCORE_VALUE_X;
+    needed_score.y = NEEDED_SCORE_RECT_Y + 1;
+    needed_score.width = HUD_MAX_DIGITS;
+}
+
+void Hud::Draw(Screen* screen, int level, uint32_t score,
+               uint32_t needed_score) {
+    if (!m_Valid) {
+        drawText(screen, "Level", LEVEL_RECT_X, LEVEL_RECT_Y);
+        drawText(screen, "Score:", SCORE_RECT_X, SCORE_RECT_Y);
+        drawText(screen, "Next level:", NEEDED_SCORE_RECT_X,
+                 NEEDED_SCORE_RECT_Y);
+
+        // No character matches a zero, so every digit gets written.
+        for (int i = 0; i < NUM_FIELDS; ++i) {
+            for (int j = 0; j < HUD_MAX_DIGITS; ++j)
+                m_Fields[i].digits[j] = '\0';
+        }
+    }
+
+    DrawField(screen, &m_Fields[LEVEL_FIELD], level);
+    DrawField(screen, &m_Fields[SCORE_FIELD], score);
+    DrawField(screen, &m_Fields[NEEDED_SCORE_FIELD], needed_score);
+    m_Valid = true;
+}
+
+void Hud::DrawField(Screen* screen, Field* field, uint32_t value) {
+    if (m_Valid && field->value == value)
+        return;
+    field->value = value;
+
+    char digits[HUD_MAX_DIGITS];
+    FormatDigits(value, digits, field->width);
+
+    // Write each run of changed characters as one string.
+    char run[HUD_MAX_DIGITS + 1];
+    int i = 0;
+    while (i < field->width) {
+        if (digits[i] == field->digits[i]) {
+            ++i;
+            continue;
+        }
+        int start = i;
+        int length = 0;
+        while (i < field->width && digits[i] != field->digits[i]) {
+            field->digits[i] = digits[i];
+            run[length++] = digits[i++];
+        }
+        run[length] = '\0';
+        drawText(screen, run, field->x + start, field->y);
+    }
+}
+
+//  Simon Que, 2013 //
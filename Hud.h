@@ -0,0 +1,55 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Hud.h
+// - Draws the level and score text, only where it changed.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+class Screen;
+
+// Widest number shown on the HUD.
+#define HUD_MAX_DIGITS    5
+
+// Writes a value into |width| characters, right aligned and padded with spaces.
+// Only the lowest |width| digits of larger values are kept.  No terminator is
+// written.
+void FormatDigits(uint32_t value, char* digits, int width);
+
+class Hud {
+  private:
+    // A number at a fixed place on the text layer.
+    struct Field {
+        uint8_t x, y;
+        uint8_t width;
+        uint32_t value;                 // Value that is on screen.
+        char digits[HUD_MAX_DIGITS];    // Characters that are on screen.
+    };
+
+    enum {
+        LEVEL_FIELD,
+        SCORE_FIELD,
+        NEEDED_SCORE_FIELD,
+        NUM_FIELDS,
+    };
+
+    Field m_Fields[NUM_FIELDS];
+    bool m_Valid;           // The labels and all fields are on screen.
+
+    // Write the characters of |field| that differ from |value|.
+    void DrawField(Screen* screen, Field* field, uint32_t value);
+
+  public:
+    Hud();
+
+    // Forget what is on screen, so the next Draw() writes everything.  Call
+    // this after the text layer has been cleared.
+    void Invalidate() { m_Valid = false; }
+
+    // Draw the HUD.  Only the digits that changed since the last call are
+    // written.
+    void Draw(Screen* screen, int level, uint32_t score, uint32_t needed_score);
+};
+
+//  Simon Que, 2013 //
@@ -8,14 +8,9 @@
 #include <stdio.h>
 
 #include "Defines.h"
-#include "Screen.h"
-
-#define abs(x)  ( ((x) >= 0) ? (x) : -(x) )
 
 void LandedSquares::SquareRow::Clear() {
-    for (int x = 0; x < SQUARES_PER_ROW; ++x)
-        squares[x].valid = false;
-    empty = true;
+    mask = 0;
 }
 
 LandedSquares::LandedSquares() {
@@ -26,94 +21,53 @@ void LandedSquares::Init() {
     Clear();
 }
 
-// Draw the squares to |screen|.
-void LandedSquares::Draw(Screen* screen) const {
-    for (int y = 0; y < MAX_NUM_LINES; ++y) {
-        const SquareRow& row = *row_ptrs[y];
-        if (row.empty)
-            continue;
-        for (int x = 0; x < SQUARES_PER_ROW; ++x) {
-            const LandedSquare& square = row.squares[x];
-            if (!square.valid)
-                continue;
-            cSquare temp_square(0, 0, square.type);
-            temp_square.SetX((GAME_AREA_LEFT + x) * SQUARE_SIZE);
-            temp_square.SetY((GAME_AREA_BOTTOM - (y + 1)) * SQUARE_SIZE);
-            screen->DrawSquare(temp_square);
-        }
+void LandedSquares::GetRowTypes(int y, uint8_t* types) const {
+    const SquareRow& row = *row_ptrs[y];
+    for (int x = 0; x < SQUARES_PER_ROW; ++x) {
+        if (row.mask & (1 << x))
+            types[x] = row.squares[x].type;
     }
 }
 
-// Iterate through each square of each row, checking for collisions.
-bool LandedSquares::CheckCollision(int square_x, int square_y,
-                                   int distance) const {
+// Look up the grid cell of the square in the row masks.
+bool LandedSquares::CheckCollision(int square_x, int square_y) const {
+    int x = square_x / SQUARE_SIZE - GAME_AREA_LEFT;
+    int y = GAME_AREA_BOTTOM - square_y / SQUARE_SIZE - 1;
+    if (x < 0 || x >= SQUARES_PER_ROW || y < 0 || y >= MAX_NUM_LINES)
+        return false;
+    return row_ptrs[y]->mask & (1 << x);
+}
+
+uint16_t LandedSquares::GetCompletedLines() const {
+    uint16_t lines = 0;
     for (int y = 0; y < MAX_NUM_LINES; ++y) {
-        const SquareRow& row = *row_ptrs[y];
-        if (row.empty)
-            continue;
-        for (int x = 0; x < SQUARES_PER_ROW; ++x) {
-            const LandedSquare& square = row.squares[x];
-            if (!square.valid)
-                continue;
-            cSquare temp_square(0, 0, square.type);
-            temp_square.SetX((GAME_AREA_LEFT + x) * SQUARE_SIZE);
-            temp_square.SetY((GAME_AREA_BOTTOM - (y + 1)) * SQUARE_SIZE);
-            int dx = square_x - temp_square.GetX();
-            int dy = square_y - temp_square.GetY();
-            if (abs(dx) < distance && abs(dy) < distance)
-                return true;
-        }
+        if (row_ptrs[y]->mask == FULL_ROW_MASK)
+            lines |= (1 << y);
     }
-    return false;
+    return lines;
 }
 
 int LandedSquares::CheckCompletedLines() {
-    // Store the amount of squares in each row in an array //
-    int squares_per_row[MAX_NUM_LINES];
-
-    // The compiler will fill the array with junk values if we don't do this //
-    for (int index = 0; index < MAX_NUM_LINES; index++)
-        squares_per_row[index] = 0;
-
     int num_lines = 0; // number of lines cleared
 
-    // Check for full lines //
-    for (int y = 0; y < MAX_NUM_LINES; ++y) {
-        const SquareRow& row = *row_ptrs[y];
-        if (row.empty)
-            continue;
-        for (int x = 0; x < SQUARES_PER_ROW; ++x) {
-            const LandedSquare& square = row.squares[x];
-            if (!square.valid)
-                continue;
-            // Increment the appropriate row counter //
-            ++squares_per_row[y];
-        }
-    }
-
     // Erase any full lines //
     for (int line = 0; line < MAX_NUM_LINES; ++line) {
         // Check for completed lines //
-        if (squares_per_row[line] != SQUARES_PER_ROW)
+        if (row_ptrs[line]->mask != FULL_ROW_MASK)
             continue;
         // Keep track of how many lines have been completed //
         num_lines++;
 
         // Clear out the current row.
         SquareRow& row = *row_ptrs[line];
-        for (int x = 0; x < SQUARES_PER_ROW; ++x)
-            row.squares[x].valid = false;
-        row.empty = true;
+        row.Clear();
 
         // Move rows above this row down.
-        for (int next_line = line + 1; next_line < MAX_NUM_LINES; ++next_line) {
+        for (int next_line = line + 1; next_line < MAX_NUM_LINES; ++next_line)
             row_ptrs[next_line - 1] = row_ptrs[next_line];
-            squares_per_row[next_line - 1] = squares_per_row[next_line];
-        }
 
         // Push the empty row to the top.
         row_ptrs[MAX_NUM_LINES - 1] = &row;
-        squares_per_row[MAX_NUM_LINES - 1] = 0;
 
         // Adjust the line counter by one because they were all shifted down.
         --line;
@@ -127,8 +81,7 @@ void LandedSquares::Add(const cSquare& square) {
     int x = square.GetX() / SQUARE_SIZE - GAME_AREA_LEFT;
     int y = GAME_AREA_BOTTOM - square.GetY() / SQUARE_SIZE - 1;
     row_ptrs[y]->squares[x].type = square.GetType();
-    row_ptrs[y]->squares[x].valid = true;
-    row_ptrs[y]->empty = false;
+    row_ptrs[y]->mask |= (RowMask)(1 << x);
 }
 
 // Clear all landed squares.
@@ -139,5 +92,11 @@ void LandedSquares::Clear() {
     }
 }
 
+// Copy the occupancy of the game field into |board|.
+void LandedSquares::GetBitboard(Bitboard* board) const {
+    for (int y = 0; y < MAX_NUM_LINES; ++y)
+        board->rows[y] = row_ptrs[y]->mask;
+}
+
 //  Aaron Cox, 2004 //
 //  Simon Que, 2013 //
@@ -7,10 +7,9 @@
 
 #include "cSquare.h"
 
+#include "Bitboard.h"
 #include "Defines.h"
 
-class Screen;
-
 class LandedSquares {
   private:
     // Use this struct to keep track of squares that have landed.  This way,
@@ -18,16 +17,13 @@ class LandedSquares {
     // that was cleared.
     struct LandedSquare {
         int type;           // Type of the block that produced this square.
-        bool valid:1;         // If this flag is not set, then the struct acts as
-                            // a placeholder in an array.
-        LandedSquare() : valid(false) {}
     };
 
     // One row of the game field.
     struct SquareRow {
         LandedSquare squares[SQUARES_PER_ROW];
-        bool empty:1;    // Indicates that this row doesn't contain any squares.
-        SquareRow() : empty(true) {}
+        RowMask mask;       // Bit x is set if squares[x] holds a square.
+        SquareRow() : mask(0) {}
         void Clear();
     };
 
@@ -43,11 +39,18 @@ class LandedSquares {
 
     void Init();
 
-    // Draw the squares to |screen|.
-    void Draw(Screen* screen) const;
+    // Write the types of the squares in row |y|, counted from the bottom,
+    // to |types|, which has SQUARES_PER_ROW entries.  The entries of empty
+    // squares are left as they are.
+    void GetRowTypes(int y, uint8_t* types) const;
+
+    // Check whether a square at the given location would overlap a landed
+    // square.  Squares always sit on the grid, so this is a single bit test.
+    bool CheckCollision(int square_x, int square_y) const;
 
-    // Iterate through each square of each row, checking for collisions.
-    bool CheckCollision(int square_x, int square_y, int distance) const;
+    // Return a mask of the full rows, bit 0 being the bottom row.  This does
+    // not clear them.
+    uint16_t GetCompletedLines() const;
 
     // Return number of lines cleared or zero if no lines were cleared.
     int CheckCompletedLines();
@@ -57,6 +60,9 @@ class LandedSquares {
 
     // Clear all landed squares.
     void Clear();
+
+    // Copy the occupancy of the game field into |board|.
+    void GetBitboard(Bitboard* board) const;
 };
 
 //  Aaron Cox, 2004 //
@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Log.cpp
+// - Implements the event log.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Log.h"
+
+#include <stddef.h>
+
+namespace {
+
+#define LOG_INDEX_MASK     (LOG_BUFFER_SIZE - 1)
+
+static_assert(LOG_DRAIN_SIZE >= 1 + LOG_MAX_ARGS * sizeof(uint16_t),
+              "Log::Read() must be able to take the largest event.");
+
+uint8_t g_buffer[LOG_BUFFER_SIZE];
+
+// Bytes written and read so far.  Only the low bits index the buffer.
+uint16_t g_write_count = 0;
+uint16_t g_read_count = 0;
+
+uint16_t g_num_lost = 0;
+
+uint16_t getFreeSpace() {
+    return LOG_BUFFER_SIZE - (uint16_t)(g_write_count - g_read_count);
+}
+
+// Size of an event with |num_args| arguments, including its header.
+uint16_t getEventSize(uint8_t num_args) {
+    return 1 + num_args * sizeof(uint16_t);
+}
+
+void putByte(uint8_t value) {
+    g_buffer[g_write_count++ & LOG_INDEX_MASK] = value;
+}
+
+void putEvent(Log::Event event, const uint16_t* args, uint8_t num_args) {
+    putByte(LOG_HEADER_FLAG | (num_args << LOG_NUM_ARGS_SHIFT) |
+            (event & LOG_EVENT_MASK));
+    for (uint8_t i = 0; i < num_args; ++i) {
+        putByte(args[i] & 0xff);
+        putByte(args[i] >> 8);
+    }
+}
+
+void writeEvent(Log::Event event, const uint16_t* args, uint8_t num_args) {
+    uint16_t size = getEventSize(num_args);
+    uint16_t lost_size = g_num_lost ? getEventSize(1) : 0;
+    if (getFreeSpace() < lost_size + size) {
+        ++g_num_lost;
+        return;
+    }
+    if (g_num_lost) {
+        putEvent(Log::EVENT_LOST, &g_num_lost, 1);
+        g_num_lost = 0;
+    }
+    putEvent(event, args, num_args);
+}
+
+}  // namespace
+
+namespace Log {
+
+    void Write(Event event) {
+        writeEvent(event, NULL, 0);
+    }
+
+    void Write(Event event, uint16_t arg0) {
+        writeEvent(event, &arg0, 1);
+    }
+
+    void Write(Event event, uint16_t arg0, uint16_t arg1) {
+        uint16_t args[] = { arg0, arg1 };
+        writeEvent(event, args, 2);
+    }
+
+    void Write(Event event, uint16_t arg0, uint16_t arg1, uint16_t arg2) {
+        uint16_t args[] = { arg0, arg1, arg2 };
+        writeEvent(event, args, 3);
+    }
+
+    uint16_t Read(uint8_t* data, uint16_t size) {
+        uint16_t num_read = 0;
+        while (g_read_count != g_write_count) {
+            uint8_t header = g_buffer[g_read_count & LOG_INDEX_MASK];
+            uint16_t event_size = getEventSize(
+                    (header >> LOG_NUM_ARGS_SHIFT) & LOG_NUM_ARGS_MASK);
+            if (num_read + event_size > size)
+                break;
+            for (uint16_t i = 0; i < event_size; ++i)
+                data[num_read++] = g_buffer[g_read_count++ & LOG_INDEX_MASK];
+        }
+        return num_read;
+    }
+
+    // FNV-1a, folded to 16 bits.
+    uint16_t HashName(const char* name) {
+        uint32_t hash = 2166136261UL;
+        for (; *name; ++name)
+            hash = (hash ^ (uint8_t)*name) * 16777619UL;
+        return (hash >> 16) ^ (hash & 0xffff);
+    }
+
+}  // namespace Log
+
+//  Simon Que, 2013 //
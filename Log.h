@@ -0,0 +1,63 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Log.h
+// - Records diagnostic events in a ring buffer in RAM.  The game sends them
+//   over serial between frames, and tools/LogDecode.cpp turns them into text.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+// Size of the ring buffer.  Must be a power of two.
+#define LOG_BUFFER_SIZE        128
+
+// Most bytes sent over serial per millisecond of idle time.  At 115200 baud,
+// the serial port sends 11.5 bytes per millisecond, so sending never has to
+// wait.  This holds the largest event, which is 7 bytes.
+#define LOG_DRAIN_SIZE           8
+
+// Each event is a header byte followed by its arguments, which are 16-bit and
+// little endian.  The header has the top bit set, the number of arguments in
+// bits 5-6, and the event in bits 0-4.  Text from printf() on the same serial
+// port never has the top bit set.
+#define LOG_HEADER_FLAG       0x80
+#define LOG_NUM_ARGS_SHIFT       5
+#define LOG_NUM_ARGS_MASK     0x03
+#define LOG_EVENT_MASK        0x1f
+#define LOG_MAX_ARGS             3
+
+namespace Log {
+
+    // The values are part of the serial format.  New events go at the end,
+    // and are described in tools/LogDecode.cpp.  The arguments of each event
+    // are listed after it.
+    enum Event {
+        EVENT_LOST,                     // Number of events dropped.
+        EVENT_FILE_OPENED,              // Name hash, size.
+        EVENT_FILE_NOT_FOUND,           // Name hash.
+        EVENT_FILE_TOO_BIG,             // Name hash, size, max size.
+        EVENT_BAD_ASSET_PACK,
+        EVENT_ASSET_PACK_READ_FAILED,   // Entry, or number of entries.
+        EVENT_STATE_STACK_FULL,         // State.
+        EVENT_STATE_STACK_EMPTY,
+        EVENT_WRITE_QUEUE_FULL,         // Layer, tilemap offset.
+        NUM_EVENTS,
+    };
+
+    // Record an event.  If the buffer is full, the event is dropped, and an
+    // EVENT_LOST with the number dropped is recorded once there is room.
+    void Write(Event event);
+    void Write(Event event, uint16_t arg0);
+    void Write(Event event, uint16_t arg0, uint16_t arg1);
+    void Write(Event event, uint16_t arg0, uint16_t arg1, uint16_t arg2);
+
+    // Takes as many whole events out of the buffer as fit in |size| bytes, so
+    // that text printed between two calls never splits an event.  Returns the
+    // number of bytes taken.
+    uint16_t Read(uint8_t* data, uint16_t size);
+
+    // File names are logged as this hash.
+    uint16_t HashName(const char* name);
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Profile.cpp
+// - Implements the frame profiler.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Profile.h"
+
+#if PROFILE_FRAMES
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Enums.h"
+#include "System.h"
+
+namespace {
+
+// The game state has a histogram for every phase, and the other states one for
+// each of the first NUM_SCREEN_PHASES.
+#define NUM_SLOTS     (Profile::NUM_PHASES + \
+                       (NUM_GAME_STATES - 1) * Profile::NUM_SCREEN_PHASES)
+
+// Counts are halved when one would overflow, which keeps the shape of the
+// histogram.
+#define MAX_COUNT     0xff
+
+const char* const kStateNames[NUM_GAME_STATES] = {
+    "Exit", "Menu", "Game", "Won", "Lost",
+};
+
+const char* const kPhaseNames[Profile::NUM_PHASES] = {
+    "frame", "input", "erase", "draw", "update",
+    "load", "gravity", "slide", "line clear", "hud",
+};
+
+uint8_t g_histograms[NUM_SLOTS][PROFILE_NUM_BUCKETS];
+
+// The frame being timed.
+uint8_t g_state = NUM_GAME_STATES;
+uint32_t g_frame_start;
+uint32_t g_phase_start;
+uint32_t g_phase_times[Profile::NUM_PHASES];
+uint16_t g_phases_ended;        // Bit per phase.
+
+// Returns the histogram of |phase| in |state|, or -1 if there is none.
+int getSlot(uint8_t state, uint8_t phase) {
+    if (state == GAME_STATE_GAME)
+        return phase;
+    if (phase >= Profile::NUM_SCREEN_PHASES)
+        return -1;
+    uint8_t index = (state < GAME_STATE_GAME) ? state : state - 1;
+    return Profile::NUM_PHASES + index * Profile::NUM_SCREEN_PHASES + phase;
+}
+
+uint8_t getBucket(uint32_t time) {
+    if (time < (1UL << PROFILE_MIN_TIME_BITS))
+        return 0;
+    uint8_t top_bit = PROFILE_MIN_TIME_BITS;
+    while (time >> (top_bit + 1))
+        ++top_bit;
+    uint16_t bucket = 1 + (top_bit - PROFILE_MIN_TIME_BITS) * 2 +
+                      ((time >> (top_bit - 1)) & 1);
+    return (bucket < PROFILE_NUM_BUCKETS) ? bucket : PROFILE_NUM_BUCKETS - 1;
+}
+
+// Returns the time that all of |bucket| is under.  The last bucket has no
+// limit, and returns the time that it starts at.
+uint32_t getBucketLimit(uint8_t bucket) {
+    if (bucket == 0)
+        return 1UL << PROFILE_MIN_TIME_BITS;
+    if (bucket >= PROFILE_NUM_BUCKETS - 1)
+        bucket = PROFILE_NUM_BUCKETS - 2;
+    uint8_t top_bit = PROFILE_MIN_TIME_BITS + (bucket - 1) / 2;
+    return (1UL << top_bit) + ((bucket - 1) % 2 + 1) * (1UL << (top_bit - 1));
+}
+
+void addTime(uint8_t state, uint8_t phase, uint32_t time) {
+    int slot = getSlot(state, phase);
+    if (slot < 0)
+        return;
+    uint8_t* counts = g_histograms[slot];
+    uint8_t bucket = getBucket(time);
+    if (counts[bucket] == MAX_COUNT) {
+        for (int i = 0; i < PROFILE_NUM_BUCKETS; ++i)
+            counts[i] /= 2;
+    }
+    ++counts[bucket];
+}
+
+// Returns the bucket that the |percent| percentile falls in.
+uint8_t getPercentileBucket(const uint8_t* counts, uint16_t total,
+                            uint8_t percent) {
+    uint32_t target = (uint32_t)total * percent;
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < PROFILE_NUM_BUCKETS; ++i) {
+        sum += counts[i];
+        if (sum * 100 >= target)
+            return i;
+    }
+    return PROFILE_NUM_BUCKETS - 1;
+}
+
+void printPercentile(const uint8_t* counts, uint16_t total, uint8_t percent) {
+    uint8_t bucket = getPercentileBucket(counts, total, percent);
+    unsigned long limit = getBucketLimit(bucket);
+    if (bucket == PROFILE_NUM_BUCKETS - 1)
+        printf("  >=%6lu", limit);
+    else
+        printf("  < %6lu", limit);
+}
+
+}  // namespace
+
+namespace Profile {
+
+    void StartFrame(uint8_t state) {
+        g_state = state;
+        g_frame_start = System::GetMicros();
+        g_phase_start = g_frame_start;
+        memset(g_phase_times, 0, sizeof(g_phase_times));
+        g_phases_ended = 0;
+    }
+
+    void EndPhase(Phase phase) {
+        uint32_t now = System::GetMicros();
+        g_phase_times[phase] += now - g_phase_start;
+        g_phase_start = now;
+        g_phases_ended |= (1 << phase);
+    }
+
+    void EndFrame() {
+        if (g_state >= NUM_GAME_STATES)
+            return;
+        addTime(g_state, PHASE_FRAME, System::GetMicros() - g_frame_start);
+        for (uint8_t phase = PHASE_FRAME + 1; phase < NUM_PHASES; ++phase) {
+            if (g_phases_ended & (1 << phase))
+                addTime(g_state, phase, g_phase_times[phase]);
+        }
+        g_state = NUM_GAME_STATES;
+    }
+
+    void Dump() {
+        printf("Frame profile in us, counts halved when full:\n");
+        printf("state phase       count       p50       p99\n");
+        for (uint8_t state = 0; state < NUM_GAME_STATES; ++state) {
+            for (uint8_t phase = 0; phase < NUM_PHASES; ++phase) {
+                int slot = getSlot(state, phase);
+                if (slot < 0)
+                    continue;
+                const uint8_t* counts = g_histograms[slot];
+                uint16_t total = 0;
+                for (int i = 0; i < PROFILE_NUM_BUCKETS; ++i)
+                    total += counts[i];
+                if (!total)
+                    continue;
+                printf("%-5s %-10s %6u", kStateNames[state], kPhaseNames[phase],
+                       total);
+                printPercentile(counts, total, 50);
+                printPercentile(counts, total, 99);
+                printf("\n");
+            }
+        }
+    }
+
+    void Reset() {
+        memset(g_histograms, 0, sizeof(g_histograms));
+    }
+
+}  // namespace Profile
+
+#endif  // PROFILE_FRAMES
+
+//  Simon Que, 2013 //
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Profile.h
+// - Times the phases of each frame, and keeps a histogram of the times of each
+//   phase in each game state.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+// Set to 1 to profile frames.  The histograms take 480 bytes of RAM, so this
+// is off by default.  When it is off, the probes do nothing.
+#ifndef PROFILE_FRAMES
+#define PROFILE_FRAMES           0
+#endif
+
+// Byte to send over serial to print the profile.
+#define PROFILE_DUMP_REQUEST   'p'
+
+// Each histogram has a bucket for times under 256 us, two buckets for each
+// power of two up to 32 ms, and a bucket for the rest.  A frame at
+// FRAMES_PER_SECOND takes up to 33 ms.
+#define PROFILE_NUM_BUCKETS     16
+#define PROFILE_MIN_TIME_BITS    8
+
+namespace Profile {
+
+    // Each phase is timed from the end of the one before it, or from the
+    // start of the frame.  PHASE_FRAME is the time of the whole frame.  All
+    // states have the phases before PHASE_GRAVITY, and only the game state has
+    // the rest.
+    enum Phase {
+        PHASE_FRAME,
+        PHASE_INPUT,            // Reading and handling input.
+        PHASE_ERASE,            // Clearing the back buffer.
+        PHASE_DRAW,             // Drawing the background, blocks and text.
+        PHASE_UPDATE,           // Updating the screen.
+        NUM_SCREEN_PHASES,
+
+        PHASE_LOAD = NUM_SCREEN_PHASES,     // Waiting for the assets to load.
+        PHASE_GRAVITY,          // Forcing the focus block down.
+        PHASE_SLIDE,            // Landing the focus block.
+        PHASE_LINE_CLEAR,       // Blinking and clearing completed lines.
+        PHASE_HUD,              // Drawing the level and score.
+        NUM_PHASES,
+    };
+
+#if PROFILE_FRAMES
+
+    // Starts timing a frame of |state|, one of GameStates.
+    void StartFrame(uint8_t state);
+
+    // Adds the time since the last call, or since StartFrame(), to |phase|.  A
+    // phase can be ended more than once in a frame.
+    void EndPhase(Phase phase);
+
+    // Adds the frame and the phases that were ended in it to the histograms.
+    void EndFrame();
+
+    // Prints the 50th and 99th percentile time of each phase that has run.
+    // Printing takes longer than a frame, so frames around it are slow.
+    void Dump();
+
+    // Empties the histograms.
+    void Reset();
+
+#else
+
+    inline void StartFrame(uint8_t state) {}
+    inline void EndPhase(Phase phase) {}
+    inline void EndFrame() {}
+    inline void Dump() {}
+    inline void Reset() {}
+
+#endif  // PROFILE_FRAMES
+
+}
+
+//  Simon Que, 2013 //
@@ -5,52 +5,15 @@
 
 #include "Screen.h"
 
-#include <Arduino.h>
-#include <DuinoCube.h>
-
-#include "cSquare.h"
+#include "Assets.h"
+#include "cBlock.h"
 #include "Defines.h"
-
-#define TILEMAP_WIDTH       32
-#define TILEMAP_HEIGHT      32
+#include "LandedSquares.h"
+#include "Log.h"
+#include "Video.h"
 
 namespace {
 
-const char kFilePath[] = "falling";    // Base path of data files.
-
-struct File {
-  const char* filename;
-  uint16_t* vram_offset;  // For image data, compute and store VRAM offset here.
-  uint16_t addr;          // For other data, store data here.
-  uint16_t bank;          // Bank to use for |addr|.
-  uint16_t max_size;      // Size checking to avoid overflow.
-};
-
-// VRAM offsets of image data.
-uint16_t g_font_offset;
-uint16_t g_squares_offset;
-uint16_t g_grass_offset;
-uint16_t g_bricks_offset;
-
-// Image, palette, and tilemap data.
-const File kFiles[] = {
-  // Layer data.
-  { "bg_grass.lay", NULL, TILEMAP(BG_LAYER_INDEX), TILEMAP_BANK, TILEMAP_SIZE },
-  { "ui_brick.lay", NULL, TILEMAP(UI_LAYER_INDEX), TILEMAP_BANK, TILEMAP_SIZE },
-
-  // Palette data.
-  { "font.pal", NULL, PALETTE(TEXT_PALETTE_INDEX), 0, PALETTE_SIZE },
-  { "squares.pal", NULL, PALETTE(BLOCKS_PALETTE_INDEX), 0, PALETTE_SIZE },
-  { "bricks.pal", NULL, PALETTE(UI_PALETTE_INDEX), 0, PALETTE_SIZE },
-  { "grass.pal", NULL, PALETTE(BG_PALETTE_INDEX), 0, PALETTE_SIZE },
-
-  // Image data.
-  { "font.raw", &g_font_offset, 0, 0, VRAM_BANK_SIZE },
-  { "squares.raw", &g_squares_offset, 0, 0, VRAM_BANK_SIZE },
-  { "bricks.raw", &g_bricks_offset, 0, 0, VRAM_BANK_SIZE },
-  { "grass.raw", &g_grass_offset, 0, 0, VRAM_BANK_SIZE },
-};
-
 // Different colors for the UI.
 const Screen::Color kColors[] = {
     { 255,  84,  17 },
@@ -61,91 +24,48 @@ const Screen::Color kColors[] = {
 };
 
 // Font colors.
-#define BLACK    0x00000000
-#define WHITE    0xffffffff
-
-// Load image, palette, and tilemap data from file system.
-void loadResources() {
-  uint16_t vram_offset = 0;
-  for (int i = 0; i < sizeof(kFiles) / sizeof(kFiles[0]); ++i) {
-    const File& file = kFiles[i];
-
-    char filename[256];
-    sprintf(filename, "%s/%s", kFilePath, file.filename);
-
-    // Open the file.
-    uint16_t handle = DC.File.open(filename, FILE_READ_ONLY);
-    if (!handle) {
-      printf("Could not open file %s.\n", filename);
-      continue;
-    }
-
-    uint16_t file_size = DC.File.size(handle);
-    printf("File %s is 0x%x bytes\n", filename, file_size);
-
-    if (file_size > file.max_size) {
-      printf("File is too big!\n");
-      DC.File.close(handle);
-      continue;
-    }
-
-    // Compute write destination.
-    uint16_t dest_addr;
-    uint16_t dest_bank;
-
-    if (file.vram_offset) {
-      // Set up for VRAM write.
-
-      // If this doesn't fit in the remaining part of the current bank, use the
-      // next VRAM bank.
-      if (vram_offset % VRAM_BANK_SIZE + file_size > VRAM_BANK_SIZE)
-        vram_offset += VRAM_BANK_SIZE - (vram_offset % VRAM_BANK_SIZE);
-
-      // Record VRAM offset.
-      *file.vram_offset = vram_offset;
-
-      // Determine the destination VRAM address and bank.
-      dest_addr = VRAM_BASE + vram_offset % VRAM_BANK_SIZE;
-      dest_bank = vram_offset / VRAM_BANK_SIZE + VRAM_BANK_BEGIN;
-      DC.Core.writeWord(REG_SYS_CTRL, (1 << REG_SYS_CTRL_VRAM_ACCESS));
-
-      // Update the VRAM offset.
-      vram_offset += file_size;
-    } else {
-      // Set up for non-VRAM write.
-      dest_addr = file.addr;
-      dest_bank = file.bank;
-    }
-
-    printf("Writing to 0x%x with bank = %d\n", dest_addr, dest_bank);
-    DC.Core.writeWord(REG_MEM_BANK, dest_bank);
-    DC.File.readToCore(handle, dest_addr, file_size);
-
-    DC.File.close(handle);
-  }
-
-  // Set to bank 0.
-  DC.Core.writeWord(REG_MEM_BANK, 0);
-
-  // Allow the graphics pipeline access to VRAM.
-  DC.Core.writeWord(REG_SYS_CTRL, (0 << REG_SYS_CTRL_VRAM_ACCESS));
+const Screen::Color kBlack = {   0,   0,   0 };
+const Screen::Color kWhite = { 255, 255, 255 };
+
+// Returns true if the assets that a layer is drawn from have been loaded.
+// Layers whose tilemaps are only drawn by the game have no tilemap asset.
+bool isLayerLoaded(int layer, bool has_tilemap, int palette,
+                   Assets::Image image) {
+    return (!has_tilemap || Assets::IsLoaded(Assets::TYPE_TILEMAP, layer)) &&
+           Assets::IsLoaded(Assets::TYPE_PALETTE, palette) &&
+           Assets::IsLoaded(Assets::TYPE_IMAGE, image);
 }
 
 }  // namespace
 
 void Screen::Init() {
-    // Load game data.
-    loadResources();
-
-    // Copy VRAM offsets to member variables.
-    m_FontDataOffset = g_font_offset;
-    m_BGDataOffset = g_grass_offset;
-    m_UIDataOffset = g_bricks_offset;
-    m_BlocksDataOffset = g_squares_offset;
+    Video::Init();
+
+    // Layers may still be on from before the MCU was reset.
+    for (int layer = 0; layer < NUM_TILE_LAYERS; ++layer)
+        Video::SetLayer(layer, 0, 0);
+    m_ShownLayers = 0;
+
+    // Load the UI palette, whose colors are cycled.  Loading uses the memory
+    // that the blocks layer state is kept in.
+    m_Blocks = NULL;
+    Assets::StartLoading();
+    m_AssetsLoaded = false;
+    while (!Assets::IsLoaded(Assets::TYPE_PALETTE, UI_PALETTE_INDEX)) {
+        if (Assets::LoadMore(ASSET_LOAD_CHUNK_SIZE)) {
+            m_AssetsLoaded = true;
+            break;
+        }
+    }
 
-    // By default, map memory bank to the tilemap bank.  There's no need to
-    // update VRAM during the game.
-    DC.Core.writeWord(REG_MEM_BANK, TILEMAP_BANK);
+    // Keep the cycled colors as loaded, twice over.
+    Video::ReadPalette(COLOR_CYCLING_PALETTE, COLOR_CYCLING_START_INDEX,
+                       m_CycledColors, NUM_CYCLED_COLORS);
+    memcpy(m_CycledColors + NUM_CYCLED_COLORS, m_CycledColors,
+           NUM_CYCLED_COLORS * sizeof(m_CycledColors[0]));
+    m_CycleStep = 0;
+    m_CycleFrames = 0;
+    m_CyclePending = false;
 
     // Manually clear the text and blocks layers.
     const int kLayers[] = { TEXT_LAYER_INDEX, BLOCKS_LAYER_INDEX };
@@ -155,60 +75,183 @@ void Screen::Init() {
     for (int i = 0; i < sizeof(kLayers) / sizeof(kLayers[0]); ++i) {
       uint16_t offset = 0;
       for (int y = 0; y < TILEMAP_HEIGHT; ++y) {
-        DC.Core.writeData(TILEMAP(kLayers[i]) + offset, cleared_buffer,
-                          sizeof(cleared_buffer));
+        Video::WriteTilemap(kLayers[i], offset, cleared_buffer,
+                            sizeof(cleared_buffer));
         offset += TILEMAP_WIDTH * BLOCK_TILE_ENTRY_SIZE;
       }
     }
 
-    // Set up two-color palette for font.
-    DC.Core.writeWord(PALETTE_ENTRY(TEXT_PALETTE_INDEX, FONT_BLACK), BLACK);
-    DC.Core.writeWord(PALETTE_ENTRY(TEXT_PALETTE_INDEX, FONT_WHITE), WHITE);
-
-    // Set up and enable tile layers.
-    DC.Core.writeWord(TILE_LAYER_REG(BG_LAYER_INDEX, TILE_CTRL_0),
-                      (1 << TILE_LAYER_ENABLED) |
-                      (BG_PALETTE_INDEX << TILE_PALETTE_START));
-    DC.Core.writeWord(TILE_LAYER_REG(BG_LAYER_INDEX, TILE_DATA_OFFSET),
-                      m_BGDataOffset);
-
-    DC.Core.writeWord(TILE_LAYER_REG(UI_LAYER_INDEX, TILE_CTRL_0),
-                      (1 << TILE_LAYER_ENABLED) |
-                      (1 << TILE_ENABLE_NOP) |
-                      (UI_PALETTE_INDEX << TILE_PALETTE_START));
-    DC.Core.writeWord(TILE_LAYER_REG(UI_LAYER_INDEX, TILE_DATA_OFFSET),
-                      m_UIDataOffset);
-    DC.Core.writeWord(TILE_LAYER_REG(UI_LAYER_INDEX, TILE_EMPTY_VALUE),
-                      DEFAULT_EMPTY_TILE_VALUE);
-
-    DC.Core.writeWord(TILE_LAYER_REG(TEXT_LAYER_INDEX, TILE_CTRL_0),
-                      (1 << TILE_LAYER_ENABLED) |
-                      (1 << TILE_ENABLE_8x8) |
-                      (1 << TILE_ENABLE_8_BIT) |
-                      (1 << TILE_ENABLE_TRANSP) |
-                      (TEXT_PALETTE_INDEX << TILE_PALETTE_START));
-    DC.Core.writeWord(TILE_LAYER_REG(TEXT_LAYER_INDEX, TILE_DATA_OFFSET),
-                      m_FontDataOffset);
-    DC.Core.writeWord(TILE_LAYER_REG(TEXT_LAYER_INDEX, TILE_COLOR_KEY),
-                      DEFAULT_TILE_COLOR_KEY);
-
-    DC.Core.writeWord(TILE_LAYER_REG(BLOCKS_LAYER_INDEX, TILE_CTRL_0),
-                      (1 << TILE_LAYER_ENABLED) |
-                      (1 << TILE_ENABLE_NOP) |
-                      (BLOCKS_PALETTE_INDEX << TILE_PALETTE_START));
-    DC.Core.writeWord(TILE_LAYER_REG(BLOCKS_LAYER_INDEX, TILE_DATA_OFFSET),
-                      m_BlocksDataOffset);
-    DC.Core.writeWord(TILE_LAYER_REG(BLOCKS_LAYER_INDEX, TILE_EMPTY_VALUE),
-                      DEFAULT_EMPTY_TILE_VALUE);
+    // Both blocks layer buffers are now empty.  Show the first one.
+    if (m_AssetsLoaded)
+        StartBlocks();
+    m_BlocksBackBuffer = 1;
+    m_FlipPending = false;
+    Video::SetLayerScroll(BLOCKS_LAYER_INDEX, 0, 0);
 
     // Set up UI color
     DrawBackground(1);
+
+    ShowLoadedLayers();
+}
+
+bool Screen::LoadAssets() {
+    if (m_AssetsLoaded)
+        return true;
+    m_AssetsLoaded = Assets::LoadMore(ASSET_LOAD_CHUNK_SIZE);
+    if (m_AssetsLoaded)
+        StartBlocks();
+    ShowLoadedLayers();
+    return m_AssetsLoaded;
+}
+
+void Screen::StartBlocks() {
+    static_assert(sizeof(BlocksState) <= ASSET_FREED_MEMORY_SIZE,
+                  "The blocks layer state must fit in the memory that "
+                  "loading used.");
+
+    // Nothing has been written to the blocks layer since Init() cleared it.
+    m_Blocks = static_cast<BlocksState*>(Assets::GetFreedMemory());
+    memset(m_Blocks->shadow, NO_BLOCK, sizeof(m_Blocks->shadow));
+    memset(m_Blocks->stale, 0, sizeof(m_Blocks->stale));
+    memset(m_Blocks->written, 0, sizeof(m_Blocks->written));
+}
+
+void Screen::FinishLoading() {
+    while (!LoadAssets());
+}
+
+void Screen::ShowLoadedLayers() {
+    // Loading reads and writes VRAM, which the layers can't draw from while
+    // the MCU has access to it.
+    if (!m_AssetsLoaded)
+        return;
+
+    if (!(m_ShownLayers & (1 << BG_LAYER_INDEX)) &&
+        isLayerLoaded(BG_LAYER_INDEX, true, BG_PALETTE_INDEX,
+                      Assets::IMAGE_GRASS)) {
+        m_BGDataOffset = Assets::GetImageOffset(Assets::IMAGE_GRASS);
+        Video::SetLayerDataOffset(BG_LAYER_INDEX, m_BGDataOffset);
+        Video::SetLayer(BG_LAYER_INDEX, Video::LAYER_ENABLED, BG_PALETTE_INDEX);
+        m_ShownLayers |= (1 << BG_LAYER_INDEX);
+    }
+
+    if (!(m_ShownLayers & (1 << UI_LAYER_INDEX)) &&
+        isLayerLoaded(UI_LAYER_INDEX, true, UI_PALETTE_INDEX,
+                      Assets::IMAGE_BRICKS)) {
+        m_UIDataOffset = Assets::GetImageOffset(Assets::IMAGE_BRICKS);
+        Video::SetLayerDataOffset(UI_LAYER_INDEX,
+                                  GetUIDataOffset(m_CurrentLevel));
+        Video::SetLayerEmptyValue(UI_LAYER_INDEX, DEFAULT_EMPTY_TILE_VALUE);
+        Video::SetLayer(UI_LAYER_INDEX,
+                        Video::LAYER_ENABLED | Video::LAYER_NOP,
+                        UI_PALETTE_INDEX);
+        m_ShownLayers |= (1 << UI_LAYER_INDEX);
+    }
+
+    if (!(m_ShownLayers & (1 << TEXT_LAYER_INDEX)) &&
+        isLayerLoaded(TEXT_LAYER_INDEX, false, TEXT_PALETTE_INDEX,
+                      Assets::IMAGE_FONT)) {
+        // Set up two-color palette for font.
+        Video::SetPaletteEntry(TEXT_PALETTE_INDEX, FONT_BLACK, kBlack);
+        Video::SetPaletteEntry(TEXT_PALETTE_INDEX, FONT_WHITE, kWhite);
+
+        m_FontDataOffset = Assets::GetImageOffset(Assets::IMAGE_FONT);
+        Video::SetLayerDataOffset(TEXT_LAYER_INDEX, m_FontDataOffset);
+        Video::SetLayerColorKey(TEXT_LAYER_INDEX, DEFAULT_TILE_COLOR_KEY);
+        Video::SetLayer(TEXT_LAYER_INDEX,
+                        Video::LAYER_ENABLED |
+                        Video::LAYER_8x8 |
+                        Video::LAYER_8_BIT |
+                        Video::LAYER_TRANSPARENT,
+                        TEXT_PALETTE_INDEX);
+        m_ShownLayers |= (1 << TEXT_LAYER_INDEX);
+    }
+
+    if (!(m_ShownLayers & (1 << BLOCKS_LAYER_INDEX)) &&
+        isLayerLoaded(BLOCKS_LAYER_INDEX, false, BLOCKS_PALETTE_INDEX,
+                      Assets::IMAGE_SQUARES)) {
+        m_BlocksDataOffset = Assets::GetImageOffset(Assets::IMAGE_SQUARES);
+        Video::SetLayerDataOffset(BLOCKS_LAYER_INDEX, m_BlocksDataOffset);
+        Video::SetLayerEmptyValue(BLOCKS_LAYER_INDEX, DEFAULT_EMPTY_TILE_VALUE);
+        Video::SetLayer(BLOCKS_LAYER_INDEX,
+                        Video::LAYER_ENABLED | Video::LAYER_NOP,
+                        BLOCKS_PALETTE_INDEX);
+        m_ShownLayers |= (1 << BLOCKS_LAYER_INDEX);
+    }
+}
+
+uint16_t Screen::GetUIDataOffset(int level) const {
+    // Each tileset type has two tiles, so advance by two tiles
+    return m_UIDataOffset + (level + 1) * SQUARE_SIZE * SQUARE_SIZE * 2;
 }
 
 void Screen::Cleanup() {
 }
 
 void Screen::Update() {
+    // The back buffer is still on screen until the last flip has happened.
+    // This is only reached if frames are drawn faster than the display.
+    while (m_FlipPending) {
+        WaitForVblank();
+        PollFlip();
+    }
+
+    // Only the back buffer is written now.  The queued writes are to tiles
+    // on screen, so they wait for PollFlip().  Until the blocks layer is
+    // tracked, both buffers are empty, and flipping them only keeps the
+    // color cycling going.
+    m_FlipPending = !m_Blocks || FlushBlocks();
+
+    // Move on to the next color cycling step.  It is uploaded with the flip.
+    if (++m_CycleFrames == COLOR_CYCLING_FRAMES) {
+        m_CycleFrames = 0;
+        m_CycleStep = (m_CycleStep + 1) % NUM_CYCLED_COLORS;
+        m_CyclePending = true;
+    }
+
+    m_LastFrameWriteStats = m_WriteStats;
+    memset(&m_WriteStats, 0, sizeof(m_WriteStats));
+}
+
+bool Screen::PollFlip() {
+    if (!m_FlipPending && !m_NumWriteSpans && !m_UIDataOffsetPending)
+        return false;
+    if (!Video::IsVblank())
+        return false;
+
+    FlushWrites();
+
+    if (m_UIDataOffsetPending) {
+        uint16_t offset = GetUIDataOffset(m_CurrentLevel);
+        Video::SetLayerDataOffset(UI_LAYER_INDEX, offset);
+        CountWrite(sizeof(offset));
+        m_UIDataOffsetPending = false;
+    }
+
+    if (!m_FlipPending)
+        return false;
+
+    Video::SetLayerScroll(BLOCKS_LAYER_INDEX, 0,
+                          m_BlocksBackBuffer * BLOCKS_BUFFER_ROWS * SQUARE_SIZE);
+    CountWrite(sizeof(uint16_t));
+    CountWrite(sizeof(uint16_t));
+
+    // The buffer that was on screen is the back buffer now.  It only differs
+    // from the tiles written where they were changed.
+    if (m_Blocks) {
+        memcpy(m_Blocks->stale, m_Blocks->written, sizeof(m_Blocks->stale));
+        memset(m_Blocks->written, 0, sizeof(m_Blocks->written));
+    }
+
+    if (m_CyclePending) {
+        Video::WritePalette(COLOR_CYCLING_PALETTE, COLOR_CYCLING_START_INDEX,
+                            m_CycledColors + m_CycleStep, NUM_CYCLED_COLORS);
+        CountWrite(NUM_CYCLED_COLORS * sizeof(m_CycledColors[0]));
+        m_CyclePending = false;
+    }
+    m_BlocksBackBuffer ^= 1;
+    m_FlipPending = false;
+    return true;
 }
 
 void Screen::Clear() {
@@ -219,55 +262,183 @@ void Screen::DrawBackground(int level) {
     if (m_CurrentLevel != level) {
         m_CurrentLevel = level;
 
-        // Update the tileset instead.
-        // Each tileset type has two tiles, so advance by two tiles
-        uint16_t offset = m_UIDataOffset +
-                         (level + 1) * SQUARE_SIZE * SQUARE_SIZE * 2;
-        DC.Core.writeWord(TILE_LAYER_REG(UI_LAYER_INDEX, TILE_DATA_OFFSET),
-                          offset);
+        // Update the tileset instead, during the next vertical blanking.
+        m_UIDataOffsetPending = true;
     }
+}
 
-    // Clear the blocks layer.
-    uint16_t buffer[GAME_AREA_WIDTH];
-    for (int x = 0; x < sizeof(buffer) / sizeof(buffer[0]); ++x)
-        buffer[x] = NO_BLOCK;
-
-    // Start at the top left corner.
-    uint16_t offset = GAME_AREA_LEFT * BLOCK_TILE_ENTRY_SIZE +
-                      GAME_AREA_TOP* TILEMAP_WIDTH * BLOCK_TILE_ENTRY_SIZE;
-    for (int y = GAME_AREA_TOP; y < GAME_AREA_BOTTOM; ++y) {
-        DC.Core.writeData(TILEMAP(BLOCKS_LAYER_INDEX) + offset,
-                          buffer, sizeof(buffer));
-        offset += TILEMAP_WIDTH * BLOCK_TILE_ENTRY_SIZE;
-    }
+void Screen::DrawBlocks(const LandedSquares* landed, uint16_t hidden_lines,
+                        const cBlock* focus, const cBlock* next) {
+    m_LandedSquares = landed;
+    m_HiddenLines = hidden_lines;
+    m_FocusBlock = focus;
+    m_NextBlock = next;
 }
 
-void Screen::DrawSquare(const cSquare& square) {
-    int tile_x = square.GetX() / SQUARE_SIZE;
-    int tile_y = square.GetY() / SQUARE_SIZE;
-    uint16_t offset = (tile_x + tile_y * TILEMAP_WIDTH) * sizeof(uint16_t);
-    DC.Core.writeWord(TILEMAP(BLOCKS_LAYER_INDEX) + offset, square.GetType());
+void Screen::GetBlocksFrameRow(int y, uint8_t* tiles) const {
+    memset(tiles, NO_BLOCK, BLOCKS_SHADOW_WIDTH);
+
+    const cBlock* blocks[] = { m_FocusBlock, m_NextBlock };
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+        if (!blocks[i])
+            continue;
+        const cSquare* squares = blocks[i]->GetSquares();
+        for (int j = 0; j < CBLOCK_NUM_SQUARES; ++j) {
+            const cSquare& square = squares[j];
+            int x = square.GetX() / SQUARE_SIZE - BLOCKS_SHADOW_LEFT;
+            if (square.GetX() < 0 || square.GetY() < 0 ||
+                square.GetY() / SQUARE_SIZE - BLOCKS_SHADOW_TOP != y ||
+                x < 0 || x >= BLOCKS_SHADOW_WIDTH) {
+                continue;
+            }
+            tiles[x] = square.GetType();
+        }
+    }
+
+    // Landed squares are drawn over the blocks, bottom row first.
+    int line = GAME_AREA_BOTTOM - 1 - (BLOCKS_SHADOW_TOP + y);
+    if (m_LandedSquares && line >= 0 && line < MAX_NUM_LINES &&
+        !(m_HiddenLines & (1 << line))) {
+        m_LandedSquares->GetRowTypes(line, tiles + GAME_AREA_LEFT -
+                                           BLOCKS_SHADOW_LEFT);
+    }
 }
 
-void Screen::EraseSquare(const cSquare& square) {
-    int tile_x = square.GetX() / SQUARE_SIZE;
-    int tile_y = square.GetY() / SQUARE_SIZE;
-    uint16_t offset = (tile_x + tile_y * TILEMAP_WIDTH) * sizeof(uint16_t);
-    DC.Core.writeWord(TILEMAP(BLOCKS_LAYER_INDEX) + offset, NO_BLOCK);
+// Compare the frame against the back buffer and write the tiles that differ.
+// The frame is made a row at a time from the landed squares and the blocks.
+// Most frames only move the four squares of the focus block.  Changed tiles
+// that are next to each other in a row are sent as one burst.  The back
+// buffer is not on screen, so this does not wait for vertical blanking.
+bool Screen::FlushBlocks() {
+    BlocksState& blocks = *m_Blocks;
+    int budget = BLOCKS_WRITE_BUDGET;
+    for (int y = 0; y < BLOCKS_SHADOW_HEIGHT; ++y) {
+        uint8_t frame[BLOCKS_SHADOW_WIDTH];
+        GetBlocksFrameRow(y, frame);
+
+        uint16_t row_offset = (BLOCKS_SHADOW_LEFT +
+                               (BLOCKS_SHADOW_TOP + y +
+                                m_BlocksBackBuffer * BLOCKS_BUFFER_ROWS) *
+                               TILEMAP_WIDTH) * BLOCK_TILE_ENTRY_SIZE;
+        uint16_t run[BLOCKS_SHADOW_WIDTH];
+        int run_start = 0;
+        int run_size = 0;
+
+        // One past the last column ends the last run.
+        for (int x = 0; x <= BLOCKS_SHADOW_WIDTH; ++x) {
+            uint16_t bit = (1 << x);
+            bool changed = x < BLOCKS_SHADOW_WIDTH &&
+                           (frame[x] != blocks.shadow[y][x] ||
+                            (blocks.stale[y] & bit));
+            if (changed && budget > 0) {
+                --budget;
+                uint8_t tile = frame[x];
+                if (run_size == 0)
+                    run_start = x;
+                run[run_size++] = tile;
+                if (tile != blocks.shadow[y][x])
+                    blocks.written[y] |= bit;
+                blocks.shadow[y][x] = tile;
+                blocks.stale[y] &= ~bit;
+                continue;
+            }
+
+            if (run_size > 0) {
+                Video::WriteTilemap(BLOCKS_LAYER_INDEX,
+                                    row_offset +
+                                    run_start * BLOCK_TILE_ENTRY_SIZE,
+                                    run, run_size * sizeof(run[0]));
+                CountWrite(run_size * sizeof(run[0]));
+                run_size = 0;
+            }
+
+            // The rest is written by the next frames.
+            if (changed)
+                return false;
+        }
+    }
+    return true;
 }
 
 void Screen::DisplayText(const char* text, int x, int y, int size,
                          int fR, int fG, int fB, int bR, int bG, int bB) {
-    DC.Core.writeData(TILEMAP(TEXT_LAYER_INDEX) + x + y * TILEMAP_WIDTH * 2,
-                      text, strlen(text));
+    QueueWrite(TEXT_LAYER_INDEX, x + y * TILEMAP_WIDTH * 2, text, strlen(text));
+}
+
+void Screen::QueueWrite(int layer, uint16_t offset, const void* data,
+                        uint16_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        if (m_WriteDataSize == WRITE_QUEUE_SIZE &&
+            !FlushFullQueue(layer, offset))
+            return;
+
+        uint16_t chunk = WRITE_QUEUE_SIZE - m_WriteDataSize;
+        if (chunk > size)
+            chunk = size;
+
+        // Extend the last span if this continues it.  Spans are never
+        // reordered, so later writes to the same address still win.
+        WriteSpan* span = NULL;
+        if (m_NumWriteSpans > 0) {
+            span = &m_WriteSpans[m_NumWriteSpans - 1];
+            if (span->layer != layer || span->offset + span->size != offset)
+                span = NULL;
+        }
+        if (!span) {
+            if (m_NumWriteSpans == WRITE_QUEUE_MAX_SPANS) {
+                if (!FlushFullQueue(layer, offset))
+                    return;
+                continue;
+            }
+            span = &m_WriteSpans[m_NumWriteSpans++];
+            span->layer = layer;
+            span->offset = offset;
+            span->data = m_WriteDataSize;
+            span->size = 0;
+        }
+
+        memcpy(m_WriteData + m_WriteDataSize, bytes, chunk);
+        m_WriteDataSize += chunk;
+        span->size += chunk;
+
+        offset += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+bool Screen::FlushFullQueue(int layer, uint16_t offset) {
+    if (!Video::IsVblank()) {
+        Log::Write(Log::EVENT_WRITE_QUEUE_FULL, layer, offset);
+        return false;
+    }
+    FlushWrites();
+    return true;
+}
+
+void Screen::FlushWrites() {
+    for (int i = 0; i < m_NumWriteSpans; ++i) {
+        const WriteSpan& span = m_WriteSpans[i];
+        Video::WriteTilemap(span.layer, span.offset, m_WriteData + span.data,
+                            span.size);
+        CountWrite(span.size);
+    }
+    m_NumWriteSpans = 0;
+    m_WriteDataSize = 0;
+}
+
+void Screen::CountWrite(uint16_t size) {
+    ++m_WriteStats.transactions;
+    m_WriteStats.bytes += size;
 }
 
 void Screen::WaitForVblank() {
-    while (!(DC.Core.readWord(REG_OUTPUT_STATUS) & (1 << REG_VBLANK)));
+    while (!Video::IsVblank());
 }
 
 void Screen::WaitForNoVblank() {
-    while ((DC.Core.readWord(REG_OUTPUT_STATUS) & (1 << REG_VBLANK)));
+    while (Video::IsVblank());
 }
 
 //  Aaron Cox, 2004 //
@@ -11,15 +11,53 @@
 
 #include "Defines.h"
 #include "Enums.h"
-
-class cSquare;
+#include "Video.h"
+
+class cBlock;
+class LandedSquares;
+
+// Part of the blocks layer that is tracked in RAM: the game area, the row
+// above it, and the next block display.  Units are tiles.
+#define BLOCKS_SHADOW_LEFT     GAME_AREA_LEFT
+#define BLOCKS_SHADOW_TOP      0
+#define BLOCKS_SHADOW_WIDTH    (NEXT_BLOCK_CIRCLE_X + 2 - BLOCKS_SHADOW_LEFT)
+#define BLOCKS_SHADOW_HEIGHT   (GAME_AREA_BOTTOM - BLOCKS_SHADOW_TOP)
+
+// The blocks layer has two buffers in its tilemap, one above the other.  One is
+// shown while the next frame is written to the other.
+#define BLOCKS_BUFFER_ROWS     16   // Tilemap rows per buffer.
+
+// Most blocks layer tiles written per frame.  Larger changes, like the rows
+// shifting down after a line clear, are spread over several frames, and the
+// buffers are only flipped once the back buffer is complete.
+#define BLOCKS_WRITE_BUDGET    32
+
+// Palette whose entries COLOR_CYCLING_START_INDEX to COLOR_CYCLING_END_INDEX
+// are cycled, and the number of frames between steps.
+#define COLOR_CYCLING_PALETTE  UI_PALETTE_INDEX
+#define COLOR_CYCLING_FRAMES   4
+
+// Bytes of assets loaded by each LoadAssets() call, and the most time in ms
+// that this takes.  The SD card is read at about 5 us per byte, and palettes
+// and tilemaps of up to 1 KB are read whole.
+#define ASSET_LOAD_CHUNK_SIZE  512
+#define ASSET_LOAD_CHUNK_TIME    6
+
+// Size of the queue of writes to tiles on screen, which are sent together by
+// PollFlip() during vertical blanking.  The most text queued before a flip is
+// the HUD's first frame (34 bytes in 6 spans), followed by the score of the
+// next frame.
+#define WRITE_QUEUE_SIZE       64   // Bytes of data.
+#define WRITE_QUEUE_MAX_SPANS  16   // Runs of contiguous addresses.
 
 class Screen {
   public:
-    // Define a custom color struct.
-    struct Color {
-        uint8_t r, g, b;
-        uint8_t unused;
+    typedef Video::Color Color;
+
+    // Core bus traffic caused by the screen during one frame.
+    struct WriteStats {
+        uint16_t transactions;          // Core write calls.
+        uint16_t bytes;                 // Bytes of data written.
     };
 
   private:
@@ -29,38 +67,171 @@ class Screen {
     uint16_t m_UIDataOffset;
     uint16_t m_BlocksDataOffset;
 
-    // Rotating part of original palette.
-    Color base_colors[NUM_CYCLED_COLORS];
+    // Rotating part of original palette, twice over.  The colors of cycling
+    // step n are the NUM_CYCLED_COLORS colors starting at n, so each step is
+    // uploaded as one contiguous write.
+    Color m_CycledColors[NUM_CYCLED_COLORS * 2];
+    uint8_t m_CycleStep;                // Step shown, or to be shown.
+    uint8_t m_CycleFrames;              // Frames since the last step.
+    bool m_CyclePending;                // Step is not uploaded yet.
 
     int m_CurrentLevel;                // Current level, used for level colors.
+    bool m_UIDataOffsetPending;        // Level's UI tiles are not shown yet.
+
+    // Tile layers that are set up and enabled, one bit per layer.  Each layer
+    // is shown once the assets it is drawn from have been loaded.
+    uint8_t m_ShownLayers;
+    bool m_AssetsLoaded;
+
+    // Set up and enable the layers whose assets have been loaded.  They stay
+    // off until loading is done.
+    void ShowLoadedLayers();
+
+    // VRAM offset of the UI tiles of a level.
+    uint16_t GetUIDataOffset(int level) const;
+
+    // What the blocks layer is drawn from.  The tiles of a frame are made
+    // from these when they are compared with the back buffer, so they are
+    // not kept in RAM.
+    const LandedSquares* m_LandedSquares;
+    uint16_t m_HiddenLines;
+    const cBlock* m_FocusBlock;
+    const cBlock* m_NextBlock;
+
+    // The tiles last written to the back buffer, and one bit per column of
+    // each row.  |stale| is set where the back buffer still holds an older
+    // tile than |shadow|.  |written| is set where the back buffer was changed
+    // since the last flip, which is where the other buffer will be stale
+    // after the flip.
+    struct BlocksState {
+        uint8_t shadow[BLOCKS_SHADOW_HEIGHT][BLOCKS_SHADOW_WIDTH];
+        uint16_t stale[BLOCKS_SHADOW_HEIGHT];
+        uint16_t written[BLOCKS_SHADOW_HEIGHT];
+    };
+
+    // In the memory that loading used, so NULL until all assets are loaded.
+    // The blocks layer is not updated before then.
+    BlocksState* m_Blocks;
+
+    uint8_t m_BlocksBackBuffer;         // Buffer that is not being shown.
+    bool m_FlipPending;                 // Back buffer is ready to be shown.
+
+    // Start tracking the blocks layer once all assets are loaded.
+    void StartBlocks();
+
+    // Write up to BLOCKS_WRITE_BUDGET changed blocks layer tiles to the back
+    // buffer.  Returns true if the back buffer now matches the frame.
+    bool FlushBlocks();
+
+    // Make row |y| of the tracked region of the frame.
+    void GetBlocksFrameRow(int y, uint8_t* tiles) const;
+
+    // Writes to tiles on screen, queued until vertical blanking.  A write
+    // that starts where the last one ended is merged into its span, so each
+    // span is one burst.
+    struct WriteSpan {
+        uint8_t layer;
+        uint16_t offset;                // Offset into the layer's tilemap.
+        uint8_t data;                   // Start of the data in m_WriteData.
+        uint8_t size;
+    };
+    uint8_t m_WriteData[WRITE_QUEUE_SIZE];
+    WriteSpan m_WriteSpans[WRITE_QUEUE_MAX_SPANS];
+    uint8_t m_WriteDataSize;
+    uint8_t m_NumWriteSpans;
+
+    WriteStats m_WriteStats;            // This frame so far.
+    WriteStats m_LastFrameWriteStats;   // The last frame that was updated.
+
+    // Queue a tilemap write.  If the queue is full, it is sent right away
+    // during vertical blanking.  Otherwise, the rest of the write is dropped
+    // and logged rather than stalling the frame.
+    void QueueWrite(int layer, uint16_t offset, const void* data,
+                    uint16_t size);
+
+    // Send the full queue if this is vertical blanking.  Otherwise, log the
+    // write at |offset| in |layer| as dropped and return false.
+    bool FlushFullQueue(int layer, uint16_t offset);
+
+    // Send the queued writes, one Video::WriteTilemap() per span.
+    void FlushWrites();
+
+    // Count one transaction of |size| bytes in the write statistics.
+    void CountWrite(uint16_t size);
 
   public:
     Screen() : m_FontDataOffset(0),
                m_BGDataOffset(0),
                m_UIDataOffset(0),
                m_BlocksDataOffset(0),
-               m_CurrentLevel(0){}
-
-    // Sets up and breaks down the video screen.
+               m_CycleStep(0),
+               m_CycleFrames(0),
+               m_CyclePending(false),
+               m_CurrentLevel(0),
+               m_UIDataOffsetPending(false),
+               m_ShownLayers(0),
+               m_AssetsLoaded(false),
+               m_LandedSquares(NULL),
+               m_HiddenLines(0),
+               m_FocusBlock(NULL),
+               m_NextBlock(NULL),
+               m_Blocks(NULL),
+               m_BlocksBackBuffer(1),
+               m_FlipPending(false),
+               m_WriteDataSize(0),
+               m_NumWriteSpans(0) {
+        memset(&m_WriteStats, 0, sizeof(m_WriteStats));
+        memset(&m_LastFrameWriteStats, 0, sizeof(m_LastFrameWriteStats));
+    }
+
+    // Sets up and breaks down the video screen.  Init() only loads the UI
+    // palette, whose colors are cycled from the first frame.  The rest are
+    // loaded by LoadAssets(), and nothing is shown until they are.
     void Init();
     void Cleanup();
 
-    // Update video buffer.
+    // Load the next ASSET_LOAD_CHUNK_SIZE bytes of assets, and show the layers
+    // that can now be drawn.  Returns true once all assets are loaded.
+    bool LoadAssets();
+    bool AreAssetsLoaded() const {
+        return m_AssetsLoaded;
+    }
+
+    // Load all assets that are not loaded yet.
+    void FinishLoading();
+
+    // Update video buffer.  Sends the blocks layer changes to the back buffer,
+    // then asks for a flip if the back buffer is complete.  If the last flip
+    // has not happened yet, this waits for it first.
     void Update();
 
+    // Once vertical blanking has started, sends the queued writes to tiles
+    // on screen, such as text, and shows the back buffer if a flip was asked
+    // for, along with the next color cycling step.  Call this often.  Returns
+    // true if the buffers were flipped.
+    bool PollFlip();
+
+    // Bus traffic of the last frame, from the end of the frame before it
+    // through its Update().
+    const WriteStats& GetFrameWriteStats() const {
+        return m_LastFrameWriteStats;
+    }
+
     // Clear the video screen to black.
     void Clear();
 
     // Draw background.
     void DrawBackground(int level);
 
-    // Draw a square.
-    void DrawSquare(const cSquare& square);
-
-    // Erase a square.
-    void EraseSquare(const cSquare& square);
+    // Draw the blocks layer from the landed squares, leaving out the rows
+    // whose bit is set in |hidden_lines|, and the focus and next blocks.
+    // Only the pointers are kept, and the blocks layer follows them until
+    // this is called again, so they must stay valid.  Any of them may be
+    // NULL.  Only the squares within the tracked region are drawn.
+    void DrawBlocks(const LandedSquares* landed, uint16_t hidden_lines,
+                    const cBlock* focus, const cBlock* next);
 
-    // Renders a string on the screen.
+    // Renders a string on the screen.  The text is queued until PollFlip().
     void DisplayText(const char* text, int x, int y, int size,
                      int fR, int fG, int fB, int bR, int bG, int bB);
 
@@ -5,11 +5,13 @@
 
 #include "StateStack.h"
 
-#include <stdio.h>
+#include <stddef.h>
+
+#include "Log.h"
 
 void StateStack::push(int state) {
     if (stack_size == STATE_STACK_MAX_SIZE) {
-        fprintf(stderr, "Attempting to push to full stack!\n");
+        Log::Write(Log::EVENT_STATE_STACK_FULL, state);
         return;
     }
     states[stack_size++] = state;
@@ -17,7 +19,7 @@ void StateStack::push(int state) {
 
 int StateStack::pop() {
     if (empty()) {
-        fprintf(stderr, "Attempting to pop from empty stack!\n");
+        Log::Write(Log::EVENT_STATE_STACK_EMPTY);
         return NULL;
     }
     return states[--stack_size];
@@ -51,4 +51,16 @@ namespace System {
         return millis();
     }
 
+    uint32_t GetMicros() {
+        return micros();
+    }
+
+    void WriteSerial(const uint8_t* data, uint16_t size) {
+        Serial.write(data, size);
+    }
+
+    int ReadSerial() {
+        return Serial.read();
+    }
+
 }  // namespace System
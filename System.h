@@ -31,4 +31,14 @@ namespace System {
 
     // Returns the number of ticks on a system timer.
     uint32_t GetTicks();
+
+    // Returns the number of microseconds on a system timer.
+    uint32_t GetMicros();
+
+    // Sends |size| bytes over the serial port.
+    void WriteSerial(const uint8_t* data, uint16_t size);
+
+    // Returns the next byte received over the serial port, or -1 if there is
+    // none.
+    int ReadSerial();
 }
@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////
+// Video.cpp
+// - Implements video functions on the DuinoCube.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Video.h"
+
+#include <stdio.h>
+
+#include <Arduino.h>
+#include <DuinoCube.h>
+
+#include "Log.h"
+
+namespace {
+
+const char kFilePath[] = "falling";    // Base path of data files.
+
+// The skip buffer and the reserved area are at the end of VRAM, after
+// IMAGE_VRAM_END.
+#define SKIP_BUFFER_OFFSET     IMAGE_VRAM_END
+#define RESERVED_MEM_OFFSET    (IMAGE_VRAM_SIZE - RESERVED_MEM_SIZE)
+
+// End of the image data loaded into VRAM so far.
+uint16_t g_vram_end = 0;
+
+// Opens a data file and checks its size.  Returns a file handle, or zero if the
+// file could not be used.
+uint16_t openFile(const char* filename, uint16_t max_size, uint16_t* size) {
+    char path[256];
+    sprintf(path, "%s/%s", kFilePath, filename);
+
+    // Open the file.
+    uint16_t name_hash = Log::HashName(filename);
+    uint16_t handle = DC.File.open(path, FILE_READ_ONLY);
+    if (!handle) {
+        Log::Write(Log::EVENT_FILE_NOT_FOUND, name_hash);
+        return 0;
+    }
+
+    *size = DC.File.size(handle);
+    if (*size > max_size) {
+        Log::Write(Log::EVENT_FILE_TOO_BIG, name_hash, *size, max_size);
+        DC.File.close(handle);
+        return 0;
+    }
+    Log::Write(Log::EVENT_FILE_OPENED, name_hash, *size);
+    return handle;
+}
+
+// Reads from an open file to the core.  Returns true if all |size| bytes were
+// read.
+bool readToCore(uint16_t handle, uint16_t dest_addr, uint16_t dest_bank,
+                uint16_t size) {
+    DC.Core.writeWord(REG_MEM_BANK, dest_bank);
+    uint16_t num_read = DC.File.readToCore(handle, dest_addr, size);
+
+    // By default, map memory bank to the tilemap bank.  There's no need to
+    // update VRAM during the game.
+    DC.Core.writeWord(REG_MEM_BANK, TILEMAP_BANK);
+    return num_read == size;
+}
+
+// Reads from an open file to VRAM.
+bool readToVRAM(uint16_t handle, uint16_t vram_offset, uint16_t size) {
+    // Determine the destination VRAM address and bank.
+    uint16_t dest_addr = VRAM_BASE + vram_offset % VRAM_BANK_SIZE;
+    uint16_t dest_bank = vram_offset / VRAM_BANK_SIZE + VRAM_BANK_BEGIN;
+
+    DC.Core.writeWord(REG_SYS_CTRL, (1 << REG_SYS_CTRL_VRAM_ACCESS));
+    bool result = readToCore(handle, dest_addr, dest_bank, size);
+
+    // Allow the graphics pipeline access to VRAM.
+    DC.Core.writeWord(REG_SYS_CTRL, (0 << REG_SYS_CTRL_VRAM_ACCESS));
+    return result;
+}
+
+// Gives the MCU access to VRAM and maps in the bank of |vram_offset|.  Returns
+// the core address of |vram_offset|.
+uint16_t mapVRAM(uint16_t vram_offset) {
+    DC.Core.writeWord(REG_SYS_CTRL, (1 << REG_SYS_CTRL_VRAM_ACCESS));
+    DC.Core.writeWord(REG_MEM_BANK,
+                      vram_offset / VRAM_BANK_SIZE + VRAM_BANK_BEGIN);
+    return VRAM_BASE + vram_offset % VRAM_BANK_SIZE;
+}
+
+// Gives VRAM back to the graphics pipeline.
+void unmapVRAM() {
+    DC.Core.writeWord(REG_MEM_BANK, TILEMAP_BANK);
+    DC.Core.writeWord(REG_SYS_CTRL, (0 << REG_SYS_CTRL_VRAM_ACCESS));
+}
+
+// Returns true if an image of |size| bytes at |vram_offset| is in one bank
+// and ends before the skip buffer.
+bool isValidImage(uint16_t vram_offset, uint32_t size) {
+    return vram_offset % VRAM_BANK_SIZE + size <= VRAM_BANK_SIZE &&
+           vram_offset + size <= IMAGE_VRAM_END;
+}
+
+// Translates Video::LAYER_* flags to the tile layer control register.
+uint16_t getLayerControl(uint16_t flags, int palette) {
+    uint16_t value = (palette << TILE_PALETTE_START);
+    if (flags & Video::LAYER_ENABLED)
+        value |= (1 << TILE_LAYER_ENABLED);
+    if (flags & Video::LAYER_NOP)
+        value |= (1 << TILE_ENABLE_NOP);
+    if (flags & Video::LAYER_8x8)
+        value |= (1 << TILE_ENABLE_8x8);
+    if (flags & Video::LAYER_8_BIT)
+        value |= (1 << TILE_ENABLE_8_BIT);
+    if (flags & Video::LAYER_TRANSPARENT)
+        value |= (1 << TILE_ENABLE_TRANSP);
+    return value;
+}
+
+}  // namespace
+
+namespace Video {
+
+    bool Init() {
+        g_vram_end = 0;
+        DC.Core.writeWord(REG_MEM_BANK, TILEMAP_BANK);
+        return true;
+    }
+
+    bool LoadTilemap(int layer, const char* filename) {
+        uint16_t size;
+        uint16_t handle = openFile(filename, TILEMAP_SIZE, &size);
+        if (!handle)
+            return false;
+        bool result = readToCore(handle, TILEMAP(layer), TILEMAP_BANK, size);
+        DC.File.close(handle);
+        return result;
+    }
+
+    bool LoadPalette(int palette, const char* filename) {
+        uint16_t size;
+        uint16_t handle = openFile(filename, PALETTE_SIZE, &size);
+        if (!handle)
+            return false;
+        bool result = readToCore(handle, PALETTE(palette), 0, size);
+        DC.File.close(handle);
+        return result;
+    }
+
+    bool LoadImage(const char* filename, uint16_t* vram_offset) {
+        uint16_t size;
+        uint16_t handle = openFile(filename, VRAM_BANK_SIZE, &size);
+        if (!handle)
+            return false;
+
+        // If this doesn't fit in the remaining part of the current bank, use
+        // the next VRAM bank.
+        if (g_vram_end % VRAM_BANK_SIZE + size > VRAM_BANK_SIZE)
+            g_vram_end += VRAM_BANK_SIZE - (g_vram_end % VRAM_BANK_SIZE);
+        if (!isValidImage(g_vram_end, size)) {
+            DC.File.close(handle);
+            return false;
+        }
+        *vram_offset = g_vram_end;
+        g_vram_end += size;
+
+        bool result = readToVRAM(handle, *vram_offset, size);
+        DC.File.close(handle);
+        return result;
+    }
+
+    uint16_t OpenFile(const char* filename, uint16_t* size) {
+        return openFile(filename, 0xffff, size);
+    }
+
+    void CloseFile(uint16_t handle) {
+        DC.File.close(handle);
+    }
+
+    uint16_t ReadFile(uint16_t handle, void* data, uint16_t size) {
+        return DC.File.read(handle, data, size);
+    }
+
+    bool ReadFileToTilemap(uint16_t handle, int layer, uint16_t size) {
+        if (size > TILEMAP_SIZE)
+            return false;
+        return readToCore(handle, TILEMAP(layer), TILEMAP_BANK, size);
+    }
+
+    bool ReadFileToPalette(uint16_t handle, int palette, uint16_t size) {
+        if (size > PALETTE_SIZE)
+            return false;
+        return readToCore(handle, PALETTE(palette), 0, size);
+    }
+
+    bool ReadFileToImage(uint16_t handle, uint16_t vram_offset, uint16_t size) {
+        if (!isValidImage(vram_offset, size))
+            return false;
+
+        // Images loaded by LoadImage() go after this one.
+        if ((uint32_t)vram_offset + size > g_vram_end)
+            g_vram_end = vram_offset + size;
+        return readToVRAM(handle, vram_offset, size);
+    }
+
+    void KeepImage(uint16_t vram_offset, uint16_t size) {
+        if ((uint32_t)vram_offset + size > g_vram_end)
+            g_vram_end = vram_offset + size;
+    }
+
+    bool SkipFile(uint16_t handle, uint16_t size) {
+        // The file API can't seek, so the coprocessor reads the data into
+        // VRAM that no image is in.
+        while (size > 0) {
+            uint16_t chunk = size;
+            if (chunk > SKIP_BUFFER_SIZE)
+                chunk = SKIP_BUFFER_SIZE;
+            if (!readToVRAM(handle, SKIP_BUFFER_OFFSET, chunk))
+                return false;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    void SetLayer(int layer, uint16_t flags, int palette) {
+        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_CTRL_0),
+                          getLayerControl(flags, palette));
+    }
+
+    void SetLayerDataOffset(int layer, uint16_t vram_offset) {
+        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_DATA_OFFSET), vram_offset);
+    }
+
+    void SetLayerEmptyValue(int layer, uint16_t value) {
+        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_EMPTY_VALUE), value);
+    }
+
+    void SetLayerColorKey(int layer, uint8_t color_key) {
+        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_COLOR_KEY), color_key);
+    }
+
+    void SetLayerScroll(int layer, uint16_t x, uint16_t y) {
+        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_OFFSET_X), x);
+        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_OFFSET_Y), y);
+    }
+
+    void SetPaletteEntry(int palette, int index, const Color& color) {
+        DC.Core.writeData(PALETTE_ENTRY(palette, index), &color, sizeof(color));
+    }
+
+    void ReadPalette(int palette, int index, Color* colors, int count) {
+        DC.Core.readData(PALETTE_ENTRY(palette, index), colors,
+                         count * sizeof(*colors));
+    }
+
+    void WritePalette(int palette, int index, const Color* colors, int count) {
+        DC.Core.writeData(PALETTE_ENTRY(palette, index), colors,
+                          count * sizeof(*colors));
+    }
+
+    void WriteTilemap(int layer, uint16_t offset, const void* data,
+                      uint16_t size) {
+        DC.Core.writeData(TILEMAP(layer) + offset, data, size);
+    }
+
+    void WriteImage(uint16_t vram_offset, const void* data, uint16_t size) {
+        if (!isValidImage(vram_offset, size))
+            return;
+        if ((uint32_t)vram_offset + size > g_vram_end)
+            g_vram_end = vram_offset + size;
+        DC.Core.writeData(mapVRAM(vram_offset), data, size);
+        unmapVRAM();
+    }
+
+    void ReadReserved(uint16_t offset, void* data, uint16_t size) {
+        if (offset + size > RESERVED_MEM_SIZE)
+            return;
+        DC.Core.readData(mapVRAM(RESERVED_MEM_OFFSET + offset), data, size);
+        unmapVRAM();
+    }
+
+    void WriteReserved(uint16_t offset, const void* data, uint16_t size) {
+        if (offset + size > RESERVED_MEM_SIZE)
+            return;
+        DC.Core.writeData(mapVRAM(RESERVED_MEM_OFFSET + offset), data, size);
+        unmapVRAM();
+    }
+
+    bool IsVblank() {
+        return DC.Core.readWord(REG_OUTPUT_STATUS) & (1 << REG_VBLANK);
+    }
+
+}  // namespace Video
+
+//  Simon Que, 2013 //
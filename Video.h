@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Video.h
+// - Handles the tile layers, palettes, and tilemaps of the video hardware.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+// Each tilemap is 32 rows of 64 bytes.  That is 32 entries per row for layers
+// with two byte entries, and 64 for layers with one byte entries.
+#define TILEMAP_WIDTH       32
+#define TILEMAP_HEIGHT      32
+
+// Number of palettes, and of colors in each of them.
+#define NUM_PALETTES         4
+#define PALETTE_NUM_COLORS 256
+
+// VRAM is divided into banks of this size.  An image must fit in one bank.
+#define IMAGE_BANK_SIZE     0x8000U
+
+// Image offsets are 16 bits, so images are in the first two banks of VRAM.
+#define IMAGE_VRAM_SIZE     0x10000UL
+
+// Size of an area of core memory that nothing is drawn from.  It keeps its
+// contents when the MCU is reset, but not when the core is powered up.  It is
+// the end of VRAM, which keeps loaded images across a reset the same way.
+#define RESERVED_MEM_SIZE     0x80
+
+// Data of skipped files is read into this much VRAM before the reserved area,
+// one piece at a time.
+#define SKIP_BUFFER_SIZE     0x100
+
+// Images end at or before this VRAM offset, so that no tile layer draws from
+// the skip buffer or the reserved area.
+#define IMAGE_VRAM_END      (IMAGE_VRAM_SIZE - SKIP_BUFFER_SIZE - \
+                             RESERVED_MEM_SIZE)
+
+// There are two implementations of this interface.  Video.cpp drives the
+// DuinoCube, and tools/HostVideo.cpp draws into memory on the host.  Only one
+// of them is linked in.
+namespace Video {
+
+    struct Color {
+        uint8_t r, g, b;
+        uint8_t unused;
+    };
+
+    // Tile layer flags.
+    enum {
+        LAYER_ENABLED     = (1 << 0),
+        LAYER_NOP         = (1 << 1),   // Don't draw tiles of the empty value.
+        LAYER_8x8         = (1 << 2),   // 8x8 tiles instead of 16x16.
+        LAYER_8_BIT       = (1 << 3),   // One byte tilemap entries.
+        LAYER_TRANSPARENT = (1 << 4),   // Don't draw pixels of the color key.
+    };
+
+    // Prepares the video hardware for drawing.
+    bool Init();
+
+    // Loads data files into a layer's tilemap, into a palette, or into VRAM.
+    // For images, the VRAM offset where the image was loaded is stored in
+    // |vram_offset|.  Each returns false if the file could not be loaded.
+    bool LoadTilemap(int layer, const char* filename);
+    bool LoadPalette(int palette, const char* filename);
+    bool LoadImage(const char* filename, uint16_t* vram_offset);
+
+    // Data files can also be read a piece at a time.  OpenFile() returns a
+    // handle and stores the file size in |size|, or returns zero if the file
+    // could not be opened.  Each read continues where the last one ended.
+    uint16_t OpenFile(const char* filename, uint16_t* size);
+    void CloseFile(uint16_t handle);
+
+    // Reads |size| bytes into |data|.  Returns the number of bytes read.
+    uint16_t ReadFile(uint16_t handle, void* data, uint16_t size);
+
+    // Reads |size| bytes into a layer's tilemap, into a palette, or into VRAM
+    // at |vram_offset|, without going through MCU memory.  Each returns false
+    // if fewer bytes were read, or if they would not fit.
+    bool ReadFileToTilemap(uint16_t handle, int layer, uint16_t size);
+    bool ReadFileToPalette(uint16_t handle, int palette, uint16_t size);
+    bool ReadFileToImage(uint16_t handle, uint16_t vram_offset, uint16_t size);
+
+    // Tells the video code that an image is still in VRAM at |vram_offset|
+    // from before the MCU was reset.  Images loaded by LoadImage() go after it.
+    void KeepImage(uint16_t vram_offset, uint16_t size);
+
+    // Skips |size| bytes of a file.  Returns false if the file ends first.
+    bool SkipFile(uint16_t handle, uint16_t size);
+
+    // Set up a tile layer.  |flags| are the LAYER_* flags above.
+    void SetLayer(int layer, uint16_t flags, int palette);
+    void SetLayerDataOffset(int layer, uint16_t vram_offset);
+    void SetLayerEmptyValue(int layer, uint16_t value);
+    void SetLayerColorKey(int layer, uint8_t color_key);
+    void SetLayerScroll(int layer, uint16_t x, uint16_t y);
+
+    // Write one palette color.
+    void SetPaletteEntry(int palette, int index, const Color& color);
+
+    // Read or write |count| consecutive palette colors, starting at |index|.
+    // Each is a single transfer.
+    void ReadPalette(int palette, int index, Color* colors, int count);
+    void WritePalette(int palette, int index, const Color* colors, int count);
+
+    // Write |size| bytes at |offset| bytes into a layer's tilemap.
+    void WriteTilemap(int layer, uint16_t offset, const void* data,
+                      uint16_t size);
+
+    // Write |size| bytes of an image at |vram_offset|.  The bytes must not
+    // cross a bank.  An image can be written in pieces, in order.
+    void WriteImage(uint16_t vram_offset, const void* data, uint16_t size);
+
+    // Read or write |size| bytes at |offset| bytes into the reserved area.
+    void ReadReserved(uint16_t offset, void* data, uint16_t size);
+    void WriteReserved(uint16_t offset, const void* data, uint16_t size);
+
+    // Returns true during vertical blanking.
+    bool IsVblank();
+}
+
+//  Simon Que, 2013 //
@@ -7,8 +7,6 @@
 
 #include <stdio.h>
 
-#include "Screen.h"
-
 // The constructor just sets the block location and calls SetupSquares //
 cBlock::cBlock(int x, int y, int type) 
         : m_CenterX(x), m_CenterY(y), m_Type(type)
@@ -107,22 +105,6 @@ void cBlock::SetupSquares(int x, int y)
     }
 }
 
-// Draw() simply iterates through the squares and calls their Draw() functions. //
-void cBlock::Draw(Screen* screen) const
-{
-    for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i)
-    {
-        screen->DrawSquare(m_Squares[i]);
-    }
-}
-
-void cBlock::Erase(Screen* screen) const
-{
-    for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i)
-        screen->EraseSquare(m_Squares[i]);
-}
-
-
 // Move() simply changes the block's center and calls the squares' move functions. //
 void cBlock::Move(Direction dir)
 {
@@ -10,8 +10,6 @@
 
 #define CBLOCK_NUM_SQUARES             4
 
-class Screen;
-
 class cBlock
 {
 private:
@@ -36,12 +34,6 @@ public:
     // squares are defined according to their distance from the block's center.
     void SetupSquares(int x, int y);
 
-    // Draw() simply iterates through the squares and calls their Draw() functions. //
-    void Draw(Screen* screen) const;
-
-    // Erase the block squares.
-    void Erase(Screen* screen) const;
-
     // Move() simply changes the block's center and calls the squares' move functions. //
     void Move(Direction dir);
 
@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////////
+// AssetLz.cpp
+// - Implements compression and decompression of assets on the host.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "AssetLz.h"
+
+#include "../Assets.h"
+
+namespace {
+
+struct Match {
+    int distance;
+    int length;
+};
+
+// Finds the longest match for the data at |pos|, preferring the nearest.
+Match findMatch(const uint8_t* data, size_t size, size_t pos) {
+    Match best = { 0, 0 };
+    size_t max_length = size - pos;
+    if (max_length > ASSET_LZ_MAX_MATCH)
+        max_length = ASSET_LZ_MAX_MATCH;
+
+    for (int distance = 1;
+         distance <= ASSET_LZ_WINDOW_SIZE && (size_t)distance <= pos;
+         ++distance) {
+        const uint8_t* source = data + pos - distance;
+        size_t length = 0;
+        while (length < max_length && source[length] == data[pos + length])
+            ++length;
+        if ((int)length > best.length) {
+            best.distance = distance;
+            best.length = length;
+            if (length == max_length)
+                break;
+        }
+    }
+    if (best.length < ASSET_LZ_MIN_MATCH)
+        best.length = 0;
+    return best;
+}
+
+}  // namespace
+
+std::vector<uint8_t> CompressLz(const uint8_t* data, size_t size) {
+    std::vector<uint8_t> output;
+    size_t flags_pos = 0;
+    int num_items = 8;
+
+    size_t pos = 0;
+    while (pos < size) {
+        if (num_items == 8) {
+            flags_pos = output.size();
+            output.push_back(0);
+            num_items = 0;
+        }
+
+        // Take a literal instead if the next byte starts a longer match.
+        Match match = findMatch(data, size, pos);
+        if (match.length > 0 && pos + 1 < size) {
+            Match next = findMatch(data, size, pos + 1);
+            if (next.length > match.length + 1)
+                match.length = 0;
+        }
+
+        if (match.length > 0) {
+            output[flags_pos] |= (1 << num_items);
+            output.push_back(match.distance - 1);
+            output.push_back(match.length - ASSET_LZ_MIN_MATCH);
+            pos += match.length;
+        } else {
+            output.push_back(data[pos]);
+            ++pos;
+        }
+        ++num_items;
+    }
+    return output;
+}
+
+bool DecompressLz(const uint8_t* data, size_t stored_size, size_t size,
+                  std::vector<uint8_t>* output) {
+    output->clear();
+    size_t pos = 0;
+    uint8_t flags = 0;
+    int num_items = 8;
+    while (output->size() < size) {
+        if (num_items == 8) {
+            if (pos >= stored_size)
+                return false;
+            flags = data[pos++];
+            num_items = 0;
+        }
+
+        if (flags & (1 << num_items)) {
+            if (pos + 2 > stored_size)
+                return false;
+            size_t distance = data[pos] + 1;
+            size_t length = data[pos + 1] + ASSET_LZ_MIN_MATCH;
+            pos += 2;
+            if (distance > output->size() || output->size() + length > size)
+                return false;
+            for (size_t i = 0; i < length; ++i)
+                output->push_back((*output)[output->size() - distance]);
+        } else {
+            if (pos >= stored_size)
+                return false;
+            output->push_back(data[pos++]);
+        }
+        ++num_items;
+    }
+    return pos == stored_size;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,21 @@
+//////////////////////////////////////////////////////////////////////////////////
+// AssetLz.h
+// - Host side coding of compressed assets.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Compresses |size| bytes in the ASSET_LZ format described in Assets.h.
+std::vector<uint8_t> CompressLz(const uint8_t* data, size_t size);
+
+// Decompresses |stored_size| bytes that should decode to |size| bytes.
+// Returns false if they do not.
+bool DecompressLz(const uint8_t* data, size_t stored_size, size_t size,
+                  std::vector<uint8_t>* output);
+
+//  Simon Que, 2013 //
@@ -0,0 +1,355 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BatchEnv.cpp
+// - Implements functions for class BatchEnv.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "BatchEnv.h"
+
+#include "Trace.h"
+#include "../cBlock.h"
+
+namespace {
+
+int GetSpeed(int level) {
+    return INITIAL_SPEED - SPEED_CHANGE * (level - 1);
+}
+
+// Bottom-left corner of a block spawned at (BLOCK_START_X, BLOCK_START_Y) and
+// rotated some number of times.  Both are taken from cBlock, so that blocks
+// spawn and rotate about their centers as they do in the game.
+struct Corner {
+    int8_t x;
+    int8_t y;
+};
+
+struct CornerTable {
+    Corner corners[NUM_BLOCK_TYPES + 1][NUM_ROTATIONS];
+
+    CornerTable() {
+        for (int type = 1; type <= NUM_BLOCK_TYPES; ++type) {
+            cBlock block(BLOCK_START_X * SQUARE_SIZE,
+                         BLOCK_START_Y * SQUARE_SIZE, type);
+            for (int rotation = 0; rotation < NUM_ROTATIONS; ++rotation) {
+                Corner& corner = corners[type][rotation];
+                corner.x = SQUARES_PER_ROW;
+                corner.y = GAME_AREA_BOTTOM;
+                const cSquare* squares = block.GetSquares();
+                for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i) {
+                    int x = squares[i].GetGridX() - GAME_AREA_LEFT;
+                    int y = GAME_AREA_BOTTOM - squares[i].GetGridY() - 1;
+                    if (x < corner.x)
+                        corner.x = x;
+                    if (y < corner.y)
+                        corner.y = y;
+                }
+                block.Rotate();
+            }
+        }
+    }
+};
+
+const Corner& GetCorner(int type, int rotation) {
+    static const CornerTable table;
+    return table.corners[type][rotation];
+}
+
+// Blocks with fewer distinct orientations repeat them, but still move when
+// they rotate, so the rotation count is kept separately from the shape.
+const BlockShape& GetShape(int type, int rotation) {
+    return GetBlockShape(type, rotation % GetNumRotations(type));
+}
+
+}  // namespace
+
+BatchEnv::BatchEnv(int num_envs, uint32_t seed)
+        : m_NumEnvs(num_envs),
+          m_Type(num_envs),
+          m_Rotation(num_envs),
+          m_X(num_envs),
+          m_Y(num_envs),
+          m_NextType(num_envs),
+          m_Level(num_envs),
+          m_Score(num_envs),
+          m_ForceDownCounter(num_envs),
+          m_SlideCounter(num_envs),
+          m_LineClearCounter(num_envs),
+          m_ClearingRows(num_envs),
+          m_RotateHeld(num_envs),
+          m_RandomState(num_envs),
+          m_Fits(num_envs),
+          m_Active(num_envs),
+          m_Moving(num_envs),
+          m_Landing(num_envs),
+          m_FullRows(num_envs) {
+    for (int y = 0; y < MAX_NUM_LINES; ++y)
+        m_Rows[y].resize(num_envs);
+
+    // Xorshift state must not be zero.
+    for (int env = 0; env < num_envs; ++env)
+        m_RandomState[env] = (seed + env) * 2654435761u | 1;
+}
+
+void BatchEnv::Reset(uint16_t* observations) {
+    for (int env = 0; env < m_NumEnvs; ++env)
+        ResetGame(env);
+    WriteObservations(observations);
+}
+
+void BatchEnv::Step(const uint8_t* actions, uint16_t* observations,
+                    float* rewards, uint8_t* dones) {
+    TRACE_SCOPE("engine", "frame");
+    const int n = m_NumEnvs;
+
+    for (int env = 0; env < n; ++env) {
+        rewards[env] = 0;
+        dones[env] = 0;
+    }
+
+    // While completed lines blink, nothing else moves.
+    for (int env = 0; env < n; ++env)
+        m_Moving[env] = m_LineClearCounter[env] == 0;
+    for (int env = 0; env < n; ++env) {
+        if (!m_Moving[env] && --m_LineClearCounter[env] == 0)
+            FinishLineClear(env, rewards, dones);
+    }
+
+    // Rotate once per press.
+    for (int env = 0; env < n; ++env) {
+        uint8_t rotate = m_Moving[env] && (actions[env] & BATCH_ACTION_ROTATE);
+        m_Active[env] = rotate && !m_RotateHeld[env];
+        if (m_Moving[env])
+            m_RotateHeld[env] = rotate;
+    }
+    CheckFit(&m_Active[0], 0, 0, true);
+    for (int env = 0; env < n; ++env) {
+        if (!m_Fits[env])
+            continue;
+        int type = m_Type[env];
+        int rotation = m_Rotation[env];
+        int next_rotation = (rotation + 1) % NUM_ROTATIONS;
+        m_X[env] += GetCorner(type, next_rotation).x -
+                    GetCorner(type, rotation).x;
+        m_Y[env] += GetCorner(type, next_rotation).y -
+                    GetCorner(type, rotation).y;
+        m_Rotation[env] = next_rotation;
+    }
+
+    // Move down, left and right, in the same order as HandleGameInput().
+    static const struct {
+        uint8_t action;
+        int8_t dx;
+        int8_t dy;
+    } kMoves[] = {
+        { BATCH_ACTION_DOWN,   0, -1 },
+        { BATCH_ACTION_LEFT,  -1,  0 },
+        { BATCH_ACTION_RIGHT,  1,  0 },
+    };
+    for (int i = 0; i < (int)(sizeof(kMoves) / sizeof(kMoves[0])); ++i) {
+        for (int env = 0; env < n; ++env)
+            m_Active[env] = m_Moving[env] && (actions[env] & kMoves[i].action);
+        CheckFit(&m_Active[0], kMoves[i].dx, kMoves[i].dy, false);
+        for (int env = 0; env < n; ++env) {
+            m_X[env] += m_Fits[env] ? kMoves[i].dx : 0;
+            m_Y[env] += m_Fits[env] ? kMoves[i].dy : 0;
+        }
+    }
+
+    // Force the focus block down.
+    for (int env = 0; env < n; ++env) {
+        m_Active[env] = m_Moving[env] &&
+                        ++m_ForceDownCounter[env] >= GetSpeed(m_Level[env]);
+    }
+    CheckFit(&m_Active[0], 0, -1, false);
+    for (int env = 0; env < n; ++env) {
+        if (m_Fits[env]) {
+            --m_Y[env];
+            m_ForceDownCounter[env] = 0;
+        }
+    }
+
+    // Count down the slide time of blocks resting on something.
+    CheckFit(&m_Moving[0], 0, -1, false);
+    for (int env = 0; env < n; ++env) {
+        m_Landing[env] = 0;
+        if (!m_Moving[env])
+            continue;
+        if (m_Fits[env]) {
+            m_SlideCounter[env] = SLIDE_TIME;
+        } else if (--m_SlideCounter[env] == 0) {
+            m_SlideCounter[env] = SLIDE_TIME;
+            m_Landing[env] = 1;
+        }
+    }
+
+    {
+        TRACE_SCOPE("engine", "lock");
+        for (int env = 0; env < n; ++env) {
+            if (m_Landing[env])
+                LockBlock(env);
+        }
+    }
+
+    {
+        TRACE_SCOPE("engine", "line clear");
+
+        // Find full rows in all games at once.
+        for (int env = 0; env < n; ++env)
+            m_FullRows[env] = 0;
+        for (int y = 0; y < MAX_NUM_LINES; ++y) {
+            const RowMask* rows = &m_Rows[y][0];
+            for (int env = 0; env < n; ++env)
+                m_FullRows[env] |= (uint16_t)(rows[env] == FULL_ROW_MASK) << y;
+        }
+
+        // The next block comes in before completed lines blink, as in
+        // HandleBottomCollision().
+        for (int env = 0; env < n; ++env) {
+            if (!m_Landing[env])
+                continue;
+            SpawnBlock(env);
+            m_ClearingRows[env] = m_FullRows[env];
+            if (m_ClearingRows[env])
+                m_LineClearCounter[env] = LINE_CLEAR_TIME;
+            else
+                FinishLineClear(env, rewards, dones);
+        }
+    }
+
+    WriteObservations(observations);
+}
+
+void BatchEnv::SetNextType(int env, uint8_t type) {
+    m_NextType[env] = type;
+}
+
+void BatchEnv::SetBlockTypes(int env, uint8_t type, uint8_t next_type) {
+    m_Type[env] = type;
+    m_NextType[env] = next_type;
+    m_Rotation[env] = 0;
+    m_X[env] = GetCorner(type, 0).x;
+    m_Y[env] = GetCorner(type, 0).y;
+}
+
+void BatchEnv::CheckFit(const uint8_t* mask, int dx, int dy, bool rotate) {
+    for (int env = 0; env < m_NumEnvs; ++env) {
+        if (!mask[env]) {
+            m_Fits[env] = 0;
+            continue;
+        }
+
+        int type = m_Type[env];
+        int rotation = m_Rotation[env];
+        int x = m_X[env] + dx;
+        int y = m_Y[env] + dy;
+        if (rotate) {
+            int next_rotation = (rotation + 1) % NUM_ROTATIONS;
+            x += GetCorner(type, next_rotation).x - GetCorner(type, rotation).x;
+            y += GetCorner(type, next_rotation).y - GetCorner(type, rotation).y;
+            rotation = next_rotation;
+        }
+        m_Fits[env] = BlockFits(env, rotation, x, y);
+    }
+}
+
+bool BatchEnv::BlockFits(int env, int rotation, int x, int y) const {
+    const BlockShape& shape = GetShape(m_Type[env], rotation);
+    if (x < 0 || x + shape.width > SQUARES_PER_ROW || y < 0)
+        return false;
+    for (int i = 0; i < shape.height && y + i < MAX_NUM_LINES; ++i) {
+        if (m_Rows[y + i][env] & (shape.rows[i] << x))
+            return false;
+    }
+    return true;
+}
+
+void BatchEnv::FinishLineClear(int env, float* rewards, uint8_t* dones) {
+    uint16_t full_rows = m_ClearingRows[env];
+    m_ClearingRows[env] = 0;
+
+    // Drop the rows above the full rows.
+    int num_lines = 0;
+    if (full_rows) {
+        int dest = 0;
+        for (int y = 0; y < MAX_NUM_LINES; ++y) {
+            if (full_rows & (1 << y)) {
+                ++num_lines;
+                continue;
+            }
+            m_Rows[dest++][env] = m_Rows[y][env];
+        }
+        while (dest < MAX_NUM_LINES)
+            m_Rows[dest++][env] = 0;
+    }
+
+    rewards[env] = num_lines;
+    m_Score[env] += POINTS_PER_LINE * num_lines;
+    if (m_Score[env] >= m_Level[env] * (uint32_t)POINTS_PER_LEVEL &&
+        ++m_Level[env] > NUM_LEVELS) {
+        dones[env] = 1;
+        ResetGame(env);
+        return;
+    }
+
+    // The game is lost if the new block cannot move down.
+    if (!BlockFits(env, m_Rotation[env], m_X[env], m_Y[env] - 1)) {
+        dones[env] = 1;
+        ResetGame(env);
+    }
+}
+
+void BatchEnv::ResetGame(int env) {
+    for (int y = 0; y < MAX_NUM_LINES; ++y)
+        m_Rows[y][env] = 0;
+    m_Level[env] = 1;
+    m_Score[env] = 0;
+    m_ForceDownCounter[env] = 0;
+    m_SlideCounter[env] = SLIDE_TIME;
+    m_LineClearCounter[env] = 0;
+    m_ClearingRows[env] = 0;
+    m_RotateHeld[env] = 0;
+    m_NextType[env] = RandomBlockType(env);
+    SpawnBlock(env);
+}
+
+void BatchEnv::SpawnBlock(int env) {
+    m_Type[env] = m_NextType[env];
+    m_NextType[env] = RandomBlockType(env);
+    m_Rotation[env] = 0;
+    m_X[env] = GetCorner(m_Type[env], 0).x;
+    m_Y[env] = GetCorner(m_Type[env], 0).y;
+}
+
+uint8_t BatchEnv::RandomBlockType(int env) {
+    uint32_t x = m_RandomState[env];
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_RandomState[env] = x;
+    return x % NUM_BLOCK_TYPES + 1;
+}
+
+// Squares above the top row are dropped.
+void BatchEnv::LockBlock(int env) {
+    const BlockShape& shape = GetShape(m_Type[env], m_Rotation[env]);
+    for (int i = 0; i < shape.height && m_Y[env] + i < MAX_NUM_LINES; ++i)
+        m_Rows[m_Y[env] + i][env] |= shape.rows[i] << m_X[env];
+}
+
+void BatchEnv::WriteObservations(uint16_t* observations) const {
+    for (int y = 0; y < MAX_NUM_LINES; ++y) {
+        const RowMask* rows = &m_Rows[y][0];
+        for (int env = 0; env < m_NumEnvs; ++env)
+            observations[env * BATCH_OBSERVATION_SIZE + y] = rows[env];
+    }
+
+    for (int env = 0; env < m_NumEnvs; ++env) {
+        uint16_t* observation = &observations[env * BATCH_OBSERVATION_SIZE];
+        const BlockShape& shape = GetShape(m_Type[env], m_Rotation[env]);
+        for (int i = 0; i < shape.height && m_Y[env] + i < MAX_NUM_LINES; ++i)
+            observation[m_Y[env] + i] |= shape.rows[i] << m_X[env];
+        observation[MAX_NUM_LINES] = m_Type[env];
+        observation[MAX_NUM_LINES + 1] = m_NextType[env];
+    }
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BatchEnv.h
+// - Steps many games in lockstep, for training agents on the host.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "../Bitboard.h"
+
+// Action bits, one byte per game.  These match the movement keys of
+// System::KeyState.  As with the up key, a block rotates once each time
+// BATCH_ACTION_ROTATE is set after a step without it.
+#define BATCH_ACTION_LEFT      (1 << 0)
+#define BATCH_ACTION_RIGHT     (1 << 1)
+#define BATCH_ACTION_DOWN      (1 << 2)
+#define BATCH_ACTION_ROTATE    (1 << 3)
+
+// Each observation is MAX_NUM_LINES row masks with the focus block drawn in,
+// followed by the focus block type and the next block type.
+#define BATCH_OBSERVATION_SIZE    (MAX_NUM_LINES + 2)
+
+// N independent games advanced one frame per Step(), with the same rules as
+// FallingBlocksGame::UpdateGame() but without any frame pacing or drawing.
+//
+// The state is stored structure-of-arrays: each field is one array indexed by
+// game, and the board is one array of row masks per line.  Each stage of a
+// step runs as a loop over all games, so the compiler can vectorize the
+// collision and line-clear loops across games.
+//
+// Blocks are tracked by orientation and the bottom-left corner of that
+// orientation, as in Solver.  Where a block spawns and how far each rotation
+// moves that corner are taken from cBlock, which rotates about the block's
+// center, so programs using this also link ../cBlock.cpp and ../cSquare.cpp.
+// As in the game, a block may rotate partly above the top row, and those
+// squares are not kept if it lands there.  Games that end are reset within
+// the same step.
+class BatchEnv {
+  public:
+    BatchEnv(int num_envs, uint32_t seed);
+
+    int GetNumEnvs() const { return m_NumEnvs; }
+
+    // Starts a new game in every slot and writes the first observations.
+    // |observations| holds GetNumEnvs() * BATCH_OBSERVATION_SIZE entries.
+    void Reset(uint16_t* observations);
+
+    // Applies one action per game and advances all games by one frame.
+    // |rewards| receives the number of lines cleared and |dones| is set for
+    // games that were won or lost during this step.
+    void Step(const uint8_t* actions, uint16_t* observations,
+              float* rewards, uint8_t* dones);
+
+    // Makes |type| the block after the focus block of game |env|, in place of
+    // the random one.  Together with SetBlockTypes(), this lets a game play
+    // the same blocks as another one.
+    void SetNextType(int env, uint8_t type);
+
+    // Restarts the focus block of game |env| at the top as |type|, and makes
+    // |next_type| the block after it.
+    void SetBlockTypes(int env, uint8_t type, uint8_t next_type);
+
+  private:
+    // Sets |m_Fits| for each game whose focus block, moved by the given
+    // amounts, lies inside the game area without overlapping landed squares.
+    // Only games with |mask| set are tested.
+    void CheckFit(const uint8_t* mask, int dx, int dy, bool rotate);
+
+    // Returns true if orientation |rotation| of the focus block of game |env|
+    // fits with its bottom-left corner at (x, y).  Rows above the top are
+    // empty, as LandedSquares::CheckCollision() treats them.
+    bool BlockFits(int env, int rotation, int x, int y) const;
+
+    // Clears the rows of |m_ClearingRows|, scores them, and resets the game if
+    // it was won or the focus block is stuck, as FinishLineClear() does.
+    void FinishLineClear(int env, float* rewards, uint8_t* dones);
+
+    void ResetGame(int env);
+    void SpawnBlock(int env);
+    uint8_t RandomBlockType(int env);
+    void LockBlock(int env);
+    void WriteObservations(uint16_t* observations) const;
+
+    int m_NumEnvs;
+
+    // m_Rows[y][env] is row y of the board of game |env|, bottom-up.
+    std::vector<RowMask> m_Rows[MAX_NUM_LINES];
+
+    std::vector<uint8_t> m_Type;         // Focus block type.
+    std::vector<uint8_t> m_Rotation;     // Rotations since the block spawned,
+                                         // modulo NUM_ROTATIONS.
+    std::vector<int8_t> m_X;             // Focus block left column.
+    std::vector<int8_t> m_Y;             // Focus block bottom row.
+    std::vector<uint8_t> m_NextType;
+    std::vector<uint8_t> m_Level;
+    std::vector<uint32_t> m_Score;
+    std::vector<uint8_t> m_ForceDownCounter;
+    std::vector<uint8_t> m_SlideCounter;
+    std::vector<uint8_t> m_LineClearCounter;
+    std::vector<uint16_t> m_ClearingRows;    // Bit y is set if row y is full.
+    std::vector<uint8_t> m_RotateHeld;   // Last action had BATCH_ACTION_ROTATE.
+    std::vector<uint32_t> m_RandomState;
+
+    // Per-step scratch arrays.
+    std::vector<uint8_t> m_Fits;
+    std::vector<uint8_t> m_Active;
+    std::vector<uint8_t> m_Moving;       // Not waiting for a line clear.
+    std::vector<uint8_t> m_Landing;
+    std::vector<uint16_t> m_FullRows;    // Bit y is set if row y is full.
+};
+
+//  Simon Que, 2013 //
@@ -0,0 +1,248 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BatchEnvTest.cpp
+// - Steps one BatchEnv game next to FallingBlocksGame::UpdateGame() with the
+//   same inputs and blocks, and checks that the boards stay the same.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -Ihost -o batch_env_test BatchEnvTest.cpp BatchEnv.cpp
+//       PlacementSearch.cpp BoardEval.cpp OpeningBook.cpp
+//       TranspositionTable.cpp Trace.cpp CoreSim.cpp ../Game.cpp ../Screen.cpp
+//       ../Assets.cpp ../Video.cpp ../System.cpp ../Hud.cpp ../StateStack.cpp
+//       ../LandedSquares.cpp ../cBlock.cpp ../cSquare.cpp ../Bitboard.cpp
+//       ../Log.cpp ../Profile.cpp
+//
+// The inputs drop each block where PlacementSearch puts it, so that lines are
+// cleared, with random keys mixed in to push blocks into walls and each other.
+// Exits with status 1 at the first frame where the games differ.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "BatchEnv.h"
+#include "CoreSim.h"
+#include "PlacementSearch.h"
+#include "../Game.h"
+
+namespace {
+
+const int kNumGames = 8;
+const int kMaxFrames = 20000;
+
+// One frame in this many has random keys.
+const int kRandomKeyFrames = 8;
+
+uint32_t g_random_state = 12345;
+
+uint32_t nextRandom() {
+    g_random_state ^= g_random_state << 13;
+    g_random_state ^= g_random_state >> 17;
+    g_random_state ^= g_random_state << 5;
+    return g_random_state;
+}
+
+int getType(const cBlock& block) {
+    return block.GetSquares()[0].GetType();
+}
+
+// Draws the squares of |block| into |rows|, bottom-up.  Squares above the
+// top row are left out, as BatchEnv leaves them out of its observations.
+void addBlock(const cBlock& block, uint16_t* rows) {
+    const cSquare* squares = block.GetSquares();
+    for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i) {
+        int x = squares[i].GetGridX() - GAME_AREA_LEFT;
+        int y = GAME_AREA_BOTTOM - squares[i].GetGridY() - 1;
+        if (y < MAX_NUM_LINES)
+            rows[y] |= 1 << x;
+    }
+}
+
+// Returns the shape of |block| shifted to (0, 0), and its left column.
+BlockShape getShape(const cBlock& block, int* left) {
+    const cSquare* squares = block.GetSquares();
+    int min_x = SQUARES_PER_ROW, max_x = 0;
+    int min_y = GAME_AREA_BOTTOM, max_y = 0;
+    for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i) {
+        int x = squares[i].GetGridX();
+        int y = GAME_AREA_BOTTOM - squares[i].GetGridY() - 1;
+        min_x = (x < min_x) ? x : min_x;
+        max_x = (x > max_x) ? x : max_x;
+        min_y = (y < min_y) ? y : min_y;
+        max_y = (y > max_y) ? y : max_y;
+    }
+
+    BlockShape shape = {};
+    shape.width = max_x - min_x + 1;
+    shape.height = max_y - min_y + 1;
+    for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i) {
+        int x = squares[i].GetGridX() - min_x;
+        int y = GAME_AREA_BOTTOM - squares[i].GetGridY() - 1 - min_y;
+        shape.rows[y] |= 1 << x;
+    }
+    *left = min_x - GAME_AREA_LEFT;
+    return shape;
+}
+
+bool sameShape(const BlockShape& a, const BlockShape& b) {
+    if (a.width != b.width || a.height != b.height)
+        return false;
+    for (int i = 0; i < a.height; ++i) {
+        if (a.rows[i] != b.rows[i])
+            return false;
+    }
+    return true;
+}
+
+// Returns true if |block| has not moved since it spawned.
+bool atSpawn(const cBlock& block) {
+    cBlock spawned(BLOCK_START_X * SQUARE_SIZE, BLOCK_START_Y * SQUARE_SIZE,
+                   getType(block));
+    for (int i = 0; i < CBLOCK_NUM_SQUARES; ++i) {
+        if (block.GetSquares()[i].GetX() != spawned.GetSquares()[i].GetX() ||
+            block.GetSquares()[i].GetY() != spawned.GetSquares()[i].GetY()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Picks the keys that move the focus block toward |target|.  The up key is
+// let go every other frame, since holding it only rotates once.
+uint8_t steer(const cBlock& block, const Placement& target, bool up_pressed) {
+    int left;
+    BlockShape shape = getShape(block, &left);
+    if (!sameShape(shape, GetBlockShape(target.type, target.rotation)))
+        return up_pressed ? 0 : BATCH_ACTION_ROTATE;
+    if (left < target.x)
+        return BATCH_ACTION_RIGHT;
+    if (left > target.x)
+        return BATCH_ACTION_LEFT;
+    return BATCH_ACTION_DOWN;
+}
+
+System::KeyState getKeyState(uint8_t action) {
+    System::KeyState key_state = {};
+    key_state.left = (action & BATCH_ACTION_LEFT) != 0;
+    key_state.right = (action & BATCH_ACTION_RIGHT) != 0;
+    key_state.down = (action & BATCH_ACTION_DOWN) != 0;
+    key_state.up = (action & BATCH_ACTION_ROTATE) != 0;
+    return key_state;
+}
+
+// Plays one game on both until it ends.  Returns false if they differ.
+bool playGame(int game_index, PlacementSearch* search, int* num_frames,
+              int* num_lines) {
+    static FallingBlocksGame game;
+    game = FallingBlocksGame();
+    game.Init();
+
+    // Init() seeds rand() from the clock, which the simulated core does not
+    // advance here.  Reseed so that each game gets different blocks.
+    srand(game_index + 1);
+
+    BatchEnv env(1, game_index);
+    uint16_t observation[BATCH_OBSERVATION_SIZE];
+    env.Reset(observation);
+    env.SetBlockTypes(0, getType(game.GetFocusBlock()),
+                      getType(game.GetNextBlock()));
+
+    Placement target = {};
+    uint8_t action = 0;
+    for (int frame = 0; frame < kMaxFrames; ++frame) {
+        const cBlock& focus = game.GetFocusBlock();
+        if (atSpawn(focus)) {
+            Bitboard board;
+            game.GetLandedSquares().GetBitboard(&board);
+            if (!search->FindBest(board, getType(focus), &target))
+                target.type = getType(focus);
+        }
+        bool up_pressed = action & BATCH_ACTION_ROTATE;
+        action = (nextRandom() % kRandomKeyFrames == 0)
+                         ? nextRandom() & 0xf
+                         : steer(focus, target, up_pressed);
+
+        game.UpdateGame(getKeyState(action));
+        float reward;
+        uint8_t done;
+        env.Step(&action, observation, &reward, &done);
+        env.SetNextType(0, getType(game.GetNextBlock()));
+        *num_lines += reward;
+        ++*num_frames;
+
+        if (done || !game.IsRunning()) {
+            if (done && !game.IsRunning())
+                return true;
+            printf("game %d frame %d: only %s ended\n", game_index, frame,
+                   done ? "BatchEnv" : "the game");
+            return false;
+        }
+
+        uint16_t rows[MAX_NUM_LINES];
+        Bitboard board;
+        game.GetLandedSquares().GetBitboard(&board);
+        for (int y = 0; y < MAX_NUM_LINES; ++y)
+            rows[y] = board.rows[y];
+        addBlock(game.GetFocusBlock(), rows);
+
+        bool same = observation[MAX_NUM_LINES] ==
+                    getType(game.GetFocusBlock());
+        for (int y = 0; y < MAX_NUM_LINES; ++y)
+            same &= observation[y] == rows[y];
+        if (!same) {
+            printf("game %d frame %d: boards differ, game then BatchEnv\n",
+                   game_index, frame);
+            for (int y = MAX_NUM_LINES - 1; y >= 0; --y) {
+                for (int x = 0; x < SQUARES_PER_ROW; ++x)
+                    putchar((rows[y] >> x) & 1 ? '#' : '.');
+                printf("   ");
+                for (int x = 0; x < SQUARES_PER_ROW; ++x)
+                    putchar((observation[y] >> x) & 1 ? '#' : '.');
+                printf("\n");
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks that the orientations cBlock goes through when rotated are the ones
+// in Bitboard's shape tables, which BatchEnv draws blocks with.
+bool checkShapes() {
+    for (int type = 1; type <= NUM_BLOCK_TYPES; ++type) {
+        cBlock block(BLOCK_START_X * SQUARE_SIZE, BLOCK_START_Y * SQUARE_SIZE,
+                     type);
+        for (int rotation = 0; rotation < NUM_ROTATIONS; ++rotation) {
+            int left;
+            const BlockShape& expected =
+                    GetBlockShape(type, rotation % GetNumRotations(type));
+            if (!sameShape(getShape(block, &left), expected)) {
+                printf("type %d rotation %d: shape differs from cBlock\n",
+                       type, rotation);
+                return false;
+            }
+            block.Rotate();
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    if (!checkShapes())
+        return 1;
+
+    DC.begin();
+    static PlacementSearch search;
+    int num_frames = 0;
+    int num_lines = 0;
+    for (int i = 0; i < kNumGames; ++i) {
+        if (!playGame(i, &search, &num_frames, &num_lines))
+            return 1;
+    }
+    printf("%d games, %d frames, %d lines: boards match\n", kNumGames,
+           num_frames, num_lines);
+    return 0;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,252 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BoardEval.cpp
+// - Implements the board feature kernels.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "BoardEval.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+// All kernels use the same method, one board per lane:
+// - The height of each column is the largest (y + 1) over the rows that have
+//   that column set.
+// - Every occupied cell is at or below the top of its column, so the number
+//   of holes is the sum of the heights minus the number of occupied cells.
+// - Bumpiness is the sum of |height[x] - height[x + 1]|.
+//
+// The scalar kernel works on one board at a time, so it uses bit scans
+// instead of testing every column of every row.
+
+namespace {
+
+void EvaluateScalar(const Bitboard* boards, int num_boards,
+                    BoardFeatures* features) {
+    for (int i = 0; i < num_boards; ++i) {
+        const Bitboard& board = boards[i];
+        int heights[SQUARES_PER_ROW] = { 0 };
+        int num_squares = 0;
+        uint32_t nonempty_rows = 0;
+
+        // Going down from the top, the columns first seen in a row have
+        // their tops in it.  Each column is found once with a bit scan.
+        RowMask seen = 0;
+        for (int y = MAX_NUM_LINES - 1; y >= 0; --y) {
+            RowMask row = board.rows[y];
+            if (!row)
+                continue;
+            num_squares += __builtin_popcount(row);
+            nonempty_rows |= 1u << y;
+            for (unsigned tops = row & ~seen; tops; tops &= tops - 1)
+                heights[__builtin_ctz(tops)] = y + 1;
+            seen |= row;
+        }
+
+        BoardFeatures& result = features[i];
+        result.aggregate_height = heights[0];
+        result.max_height =
+                nonempty_rows ? 32 - __builtin_clz(nonempty_rows) : 0;
+        result.bumpiness = 0;
+        for (int x = 1; x < SQUARES_PER_ROW; ++x) {
+            result.aggregate_height += heights[x];
+            int diff = heights[x] - heights[x - 1];
+            result.bumpiness += (diff < 0) ? -diff : diff;
+        }
+        result.holes = result.aggregate_height - num_squares;
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// Number of set bits in each 16-bit lane.
+inline __m128i PopCount16(__m128i x) {
+    const __m128i k55 = _mm_set1_epi16(0x5555);
+    const __m128i k33 = _mm_set1_epi16(0x3333);
+    const __m128i k0f = _mm_set1_epi16(0x0f0f);
+    const __m128i k1f = _mm_set1_epi16(0x001f);
+    x = _mm_sub_epi16(x, _mm_and_si128(_mm_srli_epi16(x, 1), k55));
+    x = _mm_add_epi16(_mm_and_si128(x, k33),
+                      _mm_and_si128(_mm_srli_epi16(x, 2), k33));
+    x = _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(x, 4)), k0f);
+    return _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), k1f);
+}
+
+// Copy the per-lane results of eight boards out to |features|.
+inline void StoreFeatures(__m128i aggregate, __m128i max_height,
+                          __m128i holes, __m128i bumpiness,
+                          BoardFeatures* features) {
+    int16_t a[8], m[8], h[8], b[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(a), aggregate);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m), max_height);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(h), holes);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(b), bumpiness);
+    for (int lane = 0; lane < 8; ++lane) {
+        features[lane].aggregate_height = a[lane];
+        features[lane].max_height = m[lane];
+        features[lane].holes = h[lane];
+        features[lane].bumpiness = b[lane];
+    }
+}
+
+// Evaluates boards 8 at a time.  Returns the number of boards done.
+int EvaluateSse2(const Bitboard* boards, int num_boards,
+                 BoardFeatures* features) {
+    int i = 0;
+    for (; i + 8 <= num_boards; i += 8) {
+        const Bitboard* b = &boards[i];
+        __m128i heights[SQUARES_PER_ROW];
+        for (int x = 0; x < SQUARES_PER_ROW; ++x)
+            heights[x] = _mm_setzero_si128();
+        __m128i num_squares = _mm_setzero_si128();
+
+        for (int y = 0; y < MAX_NUM_LINES; ++y) {
+            // Gather row y of the eight boards into one vector.
+            __m128i row = _mm_set_epi16(b[7].rows[y], b[6].rows[y],
+                                        b[5].rows[y], b[4].rows[y],
+                                        b[3].rows[y], b[2].rows[y],
+                                        b[1].rows[y], b[0].rows[y]);
+            num_squares = _mm_add_epi16(num_squares, PopCount16(row));
+
+            __m128i row_height = _mm_set1_epi16(y + 1);
+            for (int x = 0; x < SQUARES_PER_ROW; ++x) {
+                __m128i bit = _mm_set1_epi16(1 << x);
+                __m128i set = _mm_cmpeq_epi16(_mm_and_si128(row, bit), bit);
+                heights[x] = _mm_max_epi16(heights[x],
+                                           _mm_and_si128(set, row_height));
+            }
+        }
+
+        __m128i aggregate = heights[0];
+        __m128i max_height = heights[0];
+        __m128i bumpiness = _mm_setzero_si128();
+        for (int x = 1; x < SQUARES_PER_ROW; ++x) {
+            aggregate = _mm_add_epi16(aggregate, heights[x]);
+            max_height = _mm_max_epi16(max_height, heights[x]);
+            __m128i diff = _mm_sub_epi16(heights[x], heights[x - 1]);
+            __m128i abs_diff = _mm_max_epi16(diff,
+                                             _mm_sub_epi16(_mm_setzero_si128(),
+                                                           diff));
+            bumpiness = _mm_add_epi16(bumpiness, abs_diff);
+        }
+        __m128i holes = _mm_sub_epi16(aggregate, num_squares);
+
+        StoreFeatures(aggregate, max_height, holes, bumpiness, &features[i]);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+inline __m256i PopCount16Avx2(__m256i x) {
+    const __m256i k55 = _mm256_set1_epi16(0x5555);
+    const __m256i k33 = _mm256_set1_epi16(0x3333);
+    const __m256i k0f = _mm256_set1_epi16(0x0f0f);
+    const __m256i k1f = _mm256_set1_epi16(0x001f);
+    x = _mm256_sub_epi16(x, _mm256_and_si256(_mm256_srli_epi16(x, 1), k55));
+    x = _mm256_add_epi16(_mm256_and_si256(x, k33),
+                         _mm256_and_si256(_mm256_srli_epi16(x, 2), k33));
+    x = _mm256_and_si256(_mm256_add_epi16(x, _mm256_srli_epi16(x, 4)), k0f);
+    return _mm256_and_si256(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), k1f);
+}
+
+// Evaluates boards 16 at a time.  Returns the number of boards done.
+__attribute__((target("avx2")))
+int EvaluateAvx2(const Bitboard* boards, int num_boards,
+                 BoardFeatures* features) {
+    int i = 0;
+    for (; i + 16 <= num_boards; i += 16) {
+        const Bitboard* b = &boards[i];
+        __m256i heights[SQUARES_PER_ROW];
+        for (int x = 0; x < SQUARES_PER_ROW; ++x)
+            heights[x] = _mm256_setzero_si256();
+        __m256i num_squares = _mm256_setzero_si256();
+
+        for (int y = 0; y < MAX_NUM_LINES; ++y) {
+            __m256i row = _mm256_set_epi16(
+                    b[15].rows[y], b[14].rows[y], b[13].rows[y], b[12].rows[y],
+                    b[11].rows[y], b[10].rows[y], b[9].rows[y], b[8].rows[y],
+                    b[7].rows[y], b[6].rows[y], b[5].rows[y], b[4].rows[y],
+                    b[3].rows[y], b[2].rows[y], b[1].rows[y], b[0].rows[y]);
+            num_squares = _mm256_add_epi16(num_squares, PopCount16Avx2(row));
+
+            __m256i row_height = _mm256_set1_epi16(y + 1);
+            for (int x = 0; x < SQUARES_PER_ROW; ++x) {
+                __m256i bit = _mm256_set1_epi16(1 << x);
+                __m256i set = _mm256_cmpeq_epi16(_mm256_and_si256(row, bit),
+                                                 bit);
+                heights[x] = _mm256_max_epi16(
+                        heights[x], _mm256_and_si256(set, row_height));
+            }
+        }
+
+        __m256i aggregate = heights[0];
+        __m256i max_height = heights[0];
+        __m256i bumpiness = _mm256_setzero_si256();
+        for (int x = 1; x < SQUARES_PER_ROW; ++x) {
+            aggregate = _mm256_add_epi16(aggregate, heights[x]);
+            max_height = _mm256_max_epi16(max_height, heights[x]);
+            __m256i diff = _mm256_sub_epi16(heights[x], heights[x - 1]);
+            bumpiness = _mm256_add_epi16(bumpiness, _mm256_abs_epi16(diff));
+        }
+        __m256i holes = _mm256_sub_epi16(aggregate, num_squares);
+
+        StoreFeatures(_mm256_castsi256_si128(aggregate),
+                      _mm256_castsi256_si128(max_height),
+                      _mm256_castsi256_si128(holes),
+                      _mm256_castsi256_si128(bumpiness), &features[i]);
+        StoreFeatures(_mm256_extracti128_si256(aggregate, 1),
+                      _mm256_extracti128_si256(max_height, 1),
+                      _mm256_extracti128_si256(holes, 1),
+                      _mm256_extracti128_si256(bumpiness, 1),
+                      &features[i + 8]);
+    }
+    return i;
+}
+
+#endif  // HAVE_X86_KERNELS
+
+}  // namespace
+
+bool IsEvalKernelSupported(EvalKernel kernel) {
+    switch (kernel) {
+    case EVAL_KERNEL_BEST:
+    case EVAL_KERNEL_SCALAR:
+        return true;
+#ifdef HAVE_X86_KERNELS
+    case EVAL_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case EVAL_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#else
+    default:
+        break;
+#endif
+    }
+    return false;
+}
+
+void EvaluateBoards(const Bitboard* boards, int num_boards,
+                    BoardFeatures* features, EvalKernel kernel) {
+    if (kernel == EVAL_KERNEL_BEST) {
+        if (IsEvalKernelSupported(EVAL_KERNEL_AVX2))
+            kernel = EVAL_KERNEL_AVX2;
+        else if (IsEvalKernelSupported(EVAL_KERNEL_SSE2))
+            kernel = EVAL_KERNEL_SSE2;
+        else
+            kernel = EVAL_KERNEL_SCALAR;
+    }
+
+    int done = 0;
+#ifdef HAVE_X86_KERNELS
+    if (kernel == EVAL_KERNEL_AVX2)
+        done += EvaluateAvx2(boards, num_boards, features);
+    if (kernel == EVAL_KERNEL_AVX2 || kernel == EVAL_KERNEL_SSE2) {
+        done += EvaluateSse2(boards + done, num_boards - done,
+                             features + done);
+    }
+#endif
+    EvaluateScalar(boards + done, num_boards - done, features + done);
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BoardEval.h
+// - Computes board shape features for many boards at once.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../Bitboard.h"
+
+// Shape features of one board.
+struct BoardFeatures {
+    int16_t aggregate_height;   // Sum of the column heights.
+    int16_t max_height;         // Height of the tallest column.
+    int16_t holes;              // Empty cells below the top of their column.
+    int16_t bumpiness;          // Sum of height differences between columns.
+};
+
+// Implementations of EvaluateBoards().  They all give the same results.
+enum EvalKernel {
+    EVAL_KERNEL_BEST,       // Fastest kernel the CPU supports.
+    EVAL_KERNEL_SCALAR,
+    EVAL_KERNEL_SSE2,       // 8 boards per pass.
+    EVAL_KERNEL_AVX2,       // 16 boards per pass.
+};
+
+// Returns true if |kernel| can run on this CPU.
+bool IsEvalKernelSupported(EvalKernel kernel);
+
+// Fills in |features[i]| for each of |boards[i]|.  Any number of boards is
+// accepted; boards left over after the last full SIMD pass are done by the
+// narrower kernels.
+void EvaluateBoards(const Bitboard* boards, int num_boards,
+                    BoardFeatures* features,
+                    EvalKernel kernel = EVAL_KERNEL_BEST);
+
+//  Simon Que, 2013 //
@@ -0,0 +1,126 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BoardEvalBench.cpp
+// - Measures the throughput of each EvaluateBoards() kernel in boards/second,
+//   and its speed relative to the scalar kernel.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o board_eval_bench BoardEvalBench.cpp BoardEval.cpp ../Bitboard.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "BoardEval.h"
+
+namespace {
+
+const int kNumBoards = 4096;
+const int kNumPasses = 2000;
+
+// Random boards that are denser at the bottom, like boards seen in play.
+void MakeBoards(std::vector<Bitboard>* boards) {
+    srand(1);
+    for (size_t i = 0; i < boards->size(); ++i) {
+        Bitboard& board = (*boards)[i];
+        int height = rand() % (MAX_NUM_LINES + 1);
+        for (int y = 0; y < MAX_NUM_LINES; ++y)
+            board.rows[y] = (y < height) ? (rand() & FULL_ROW_MASK) : 0;
+    }
+}
+
+// Features found by testing every cell, to check the kernels against.
+void EvaluateReference(const Bitboard& board, BoardFeatures* features) {
+    int heights[SQUARES_PER_ROW] = { 0 };
+    int num_squares = 0;
+    for (int y = 0; y < MAX_NUM_LINES; ++y) {
+        for (int x = 0; x < SQUARES_PER_ROW; ++x) {
+            if (board.Get(x, y)) {
+                heights[x] = y + 1;
+                ++num_squares;
+            }
+        }
+    }
+
+    features->aggregate_height = 0;
+    features->max_height = 0;
+    features->bumpiness = 0;
+    for (int x = 0; x < SQUARES_PER_ROW; ++x) {
+        features->aggregate_height += heights[x];
+        if (heights[x] > features->max_height)
+            features->max_height = heights[x];
+        if (x > 0) {
+            int diff = heights[x] - heights[x - 1];
+            features->bumpiness += (diff < 0) ? -diff : diff;
+        }
+    }
+    features->holes = features->aggregate_height - num_squares;
+}
+
+bool SameFeatures(const BoardFeatures& a, const BoardFeatures& b) {
+    return a.aggregate_height == b.aggregate_height &&
+           a.max_height == b.max_height &&
+           a.holes == b.holes &&
+           a.bumpiness == b.bumpiness;
+}
+
+}  // namespace
+
+int main() {
+    static const struct {
+        EvalKernel kernel;
+        const char* name;
+    } kKernels[] = {
+        { EVAL_KERNEL_SCALAR, "scalar" },
+        { EVAL_KERNEL_SSE2,   "sse2" },
+        { EVAL_KERNEL_AVX2,   "avx2" },
+    };
+
+    std::vector<Bitboard> boards(kNumBoards);
+    MakeBoards(&boards);
+
+    std::vector<BoardFeatures> expected(kNumBoards);
+    for (int i = 0; i < kNumBoards; ++i)
+        EvaluateReference(boards[i], &expected[i]);
+
+    int result = 0;
+    double scalar_rate = 0;
+    std::vector<BoardFeatures> features(kNumBoards);
+    for (size_t k = 0; k < sizeof(kKernels) / sizeof(kKernels[0]); ++k) {
+        if (!IsEvalKernelSupported(kKernels[k].kernel)) {
+            printf("%-8s not supported\n", kKernels[k].name);
+            continue;
+        }
+
+        EvaluateBoards(&boards[0], kNumBoards, &features[0],
+                       kKernels[k].kernel);
+        for (int i = 0; i < kNumBoards; ++i) {
+            if (!SameFeatures(features[i], expected[i])) {
+                printf("%-8s mismatch at board %d\n", kKernels[k].name, i);
+                result = 1;
+                break;
+            }
+        }
+
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        for (int pass = 0; pass < kNumPasses; ++pass) {
+            EvaluateBoards(&boards[0], kNumBoards, &features[0],
+                           kKernels[k].kernel);
+        }
+        double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+        // The scalar kernel comes first, and the others are compared to it.
+        double rate = (double)kNumBoards * kNumPasses / seconds;
+        if (kKernels[k].kernel == EVAL_KERNEL_SCALAR)
+            scalar_rate = rate;
+        printf("%-8s %12.0f boards/s %6.1fx scalar\n", kKernels[k].name, rate,
+               rate / scalar_rate);
+    }
+    return result;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,512 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BuildAssets.cpp
+// - Regenerates the tilesets, palettes, tilemaps and PROGMEM headers in Data
+//   from their .bmp and .tmx sources.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o build_assets BuildAssets.cpp -lz
+//
+// Usage: build_assets [--check] [data_dir]
+//   Writes the generated files into data_dir, which is ../Data by default.
+//   With --check, nothing is written, and the exit status is 1 if any file
+//   differs from what would be generated.  Run pack_assets afterwards to
+//   rebuild the asset archive.
+//
+// Identical tiles are merged in tilesets that are only drawn through the
+// tilemaps built here, and those tilemaps are renumbered to match.  The font
+// is indexed by character code, the UI bricks by level, and the blocks by
+// block type, so their tiles keep their places.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "../Video.h"
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+// A PROGMEM header holding a copy of a generated file.
+struct Header {
+    const char* filename;
+    const char* symbol;     // Prefix of the names declared in it.
+};
+
+struct TilesetSource {
+    const char* bmp;
+    int tile_size;
+    bool merge_tiles;       // Only used through the tilemaps below.
+    const char* raw;
+    const char* pal;
+    Header raw_header;
+    Header pal_header;
+};
+
+struct TilemapSource {
+    const char* tmx;        // Names its tileset's .bmp.
+    const char* lay;
+    Header header;
+};
+
+const TilesetSource kTilesets[] = {
+    { "bricks.bmp", 16, false, "bricks.raw", "bricks.pal",
+      { "bricks.raw.h", "bricks_bmp_raw" },
+      { "bricks.pal.h", "bricks_bmp_pal" } },
+    { "grass.bmp", 16, true, "grass.raw", "grass.pal",
+      { NULL, NULL },
+      { NULL, NULL } },
+    { "font.bmp", 8, false, "font.raw", "font.pal",
+      { NULL, NULL },
+      { NULL, NULL } },
+    { "squares.bmp", 16, false, "squares.raw", "squares.pal",
+      { "squares_tileset.h", "squares_bmp_raw" },
+      { "squares_palette.h", "squares_bmp_pal" } },
+};
+
+const TilemapSource kTilemaps[] = {
+    { "bg_grass.tmx", "bg_grass.lay", { NULL, NULL } },
+    { "ui_brick.tmx", "ui_brick.lay",
+      { "ui_bricks.map.h", "ui_bricks_tmx_layer0_dat" } },
+};
+
+#define NUM_ELEMENTS(array)  (sizeof(array) / sizeof(array[0]))
+
+// Tilemap entry of cells without a tile.  Tiled numbers tiles from one, and
+// the maps have always stored the tile number minus one, 13 bits wide.
+const uint16_t kEmptyTile = 0x1fff;
+
+// Tiled keeps flip flags in the top bits of each tile number.
+const uint32_t kTileNumberMask = 0x1fffffff;
+
+// Header files have this many 32-bit words per line.
+const int kWordsPerLine = 8;
+
+// A tileset after its tiles were cut out and possibly merged.
+struct Tileset {
+    Bytes raw;                      // Tile after tile, row by row.
+    Bytes pal;
+    std::vector<uint16_t> remap;    // New index of each tile in the image.
+};
+
+const char* g_data_dir = "../Data";
+bool g_check = false;
+int g_num_changed = 0;
+
+bool readFile(const std::string& path, Bytes* data) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    data->clear();
+    uint8_t buffer[4096];
+    size_t num_read;
+    while ((num_read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data->insert(data->end(), buffer, buffer + num_read);
+    fclose(file);
+    return true;
+}
+
+std::string getPath(const char* filename) {
+    return std::string(g_data_dir) + "/" + filename;
+}
+
+// Writes a generated file, or with --check, compares it with the one there.
+bool writeOutput(const char* filename, const Bytes& data) {
+    std::string path = getPath(filename);
+    Bytes old_data;
+    if (readFile(path, &old_data) && old_data == data) {
+        printf("  %-20s unchanged\n", filename);
+        return true;
+    }
+
+    ++g_num_changed;
+    if (g_check) {
+        printf("  %-20s differs\n", filename);
+        return true;
+    }
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        if (file)
+            fclose(file);
+        return false;
+    }
+    fclose(file);
+    printf("  %-20s written\n", filename);
+    return true;
+}
+
+// Builds a header in the format of the existing ones: the data as 32-bit
+// words in program memory, with byte and halfword pointers to it.
+Bytes makeHeader(const Header& header, const Bytes& data) {
+    std::string symbol = header.symbol;
+    std::string upper_symbol;
+    for (size_t i = 0; i < symbol.size(); ++i)
+        upper_symbol += toupper(symbol[i]);
+
+    std::string text = "#include <stdint.h>\n#include <avr/pgmspace.h>\n";
+    text += "const uint32_t " + symbol + "_data32[] PROGMEM = {\n";
+    char word[16];
+    for (size_t i = 0; i < data.size(); i += 4) {
+        uint32_t value = 0;
+        for (size_t j = 0; j < 4 && i + j < data.size(); ++j)
+            value |= data[i + j] << (j * 8);
+        if ((i / 4) % kWordsPerLine == 0)
+            text += "\t";
+        snprintf(word, sizeof(word), "0x%04x,", value);
+        text += word;
+        if ((i / 4) % kWordsPerLine == kWordsPerLine - 1 || i + 4 >= data.size())
+            text += "\n";
+    }
+    text += "};\n";
+    text += "uint8_t* " + symbol + "_data8 = (uint8_t*) " + symbol +
+            "_data32;\n";
+    text += "uint16_t* " + symbol + "_data16 = (uint16_t*) " + symbol +
+            "_data32;\n";
+    snprintf(word, sizeof(word), "%u", (unsigned)data.size());
+    text += "const int " + upper_symbol + "_DATA_SIZE = " + word + ";\n";
+    return Bytes(text.begin(), text.end());
+}
+
+bool writeWithHeader(const char* filename, const Header& header,
+                     const Bytes& data) {
+    if (!writeOutput(filename, data))
+        return false;
+    return !header.filename ||
+           writeOutput(header.filename, makeHeader(header, data));
+}
+
+uint32_t readLE(const Bytes& data, size_t pos, int size) {
+    uint32_t value = 0;
+    for (int i = 0; i < size; ++i)
+        value |= data[pos + i] << (i * 8);
+    return value;
+}
+
+// Reads an uncompressed 8-bit BMP into rows of color indexes, top row first,
+// and a palette of Video::Colors padded to PALETTE_NUM_COLORS.
+bool readBMP(const char* filename, int* width, int* height, Bytes* pixels,
+             Bytes* pal) {
+    Bytes data;
+    if (!readFile(getPath(filename), &data) || data.size() < 54 ||
+        data[0] != 'B' || data[1] != 'M') {
+        fprintf(stderr, "Could not read %s\n", filename);
+        return false;
+    }
+    uint32_t data_offset = readLE(data, 10, 4);
+    uint32_t header_size = readLE(data, 14, 4);
+    int32_t bmp_width = readLE(data, 18, 4);
+    int32_t bmp_height = readLE(data, 22, 4);
+    int bits = readLE(data, 28, 2);
+    int compression = readLE(data, 30, 4);
+    uint32_t num_colors = readLE(data, 46, 4);
+    if (bits != 8 || compression != 0 || bmp_width <= 0) {
+        fprintf(stderr, "%s is not an uncompressed 8-bit BMP\n", filename);
+        return false;
+    }
+    if (num_colors == 0 || num_colors > PALETTE_NUM_COLORS)
+        num_colors = PALETTE_NUM_COLORS;
+
+    // BMP colors are blue, green, red, unused.
+    pal->assign(PALETTE_NUM_COLORS * sizeof(Video::Color), 0);
+    for (uint32_t i = 0; i < num_colors; ++i) {
+        size_t pos = 14 + header_size + i * 4;
+        if (pos + 4 > data.size())
+            break;
+        (*pal)[i * 4 + 0] = data[pos + 2];
+        (*pal)[i * 4 + 1] = data[pos + 1];
+        (*pal)[i * 4 + 2] = data[pos + 0];
+    }
+
+    // Rows are stored bottom up unless the height is negative, and padded to
+    // four bytes.
+    bool bottom_up = bmp_height > 0;
+    *width = bmp_width;
+    *height = bottom_up ? bmp_height : -bmp_height;
+    size_t stride = (*width + 3) & ~3;
+    if (data_offset + stride * *height > data.size()) {
+        fprintf(stderr, "%s is truncated\n", filename);
+        return false;
+    }
+    pixels->resize(*width * *height);
+    for (int y = 0; y < *height; ++y) {
+        int row = bottom_up ? *height - 1 - y : y;
+        memcpy(&(*pixels)[y * *width], &data[data_offset + stride * row],
+               *width);
+    }
+    return true;
+}
+
+bool buildTileset(const TilesetSource& source, Tileset* tileset) {
+    int width, height;
+    Bytes pixels;
+    if (!readBMP(source.bmp, &width, &height, &pixels, &tileset->pal))
+        return false;
+    int size = source.tile_size;
+    if (width % size || height % size) {
+        fprintf(stderr, "%s is not made of %dx%d tiles\n", source.bmp, size,
+                size);
+        return false;
+    }
+
+    // Cut the image into tiles, left to right and then top to bottom.
+    std::vector<Bytes> tiles;
+    for (int tile_y = 0; tile_y < height; tile_y += size) {
+        for (int tile_x = 0; tile_x < width; tile_x += size) {
+            Bytes tile;
+            for (int y = 0; y < size; ++y) {
+                const uint8_t* row = &pixels[(tile_y + y) * width + tile_x];
+                tile.insert(tile.end(), row, row + size);
+            }
+            tiles.push_back(tile);
+        }
+    }
+
+    std::map<Bytes, uint16_t> unique_tiles;
+    tileset->raw.clear();
+    tileset->remap.clear();
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        uint16_t index = unique_tiles.size();
+        if (source.merge_tiles) {
+            std::map<Bytes, uint16_t>::iterator it = unique_tiles.find(tiles[i]);
+            if (it != unique_tiles.end()) {
+                tileset->remap.push_back(it->second);
+                continue;
+            }
+        }
+        unique_tiles.insert(std::make_pair(tiles[i], index));
+        tileset->remap.push_back(source.merge_tiles ? index : i);
+        tileset->raw.insert(tileset->raw.end(), tiles[i].begin(),
+                            tiles[i].end());
+    }
+    if (tileset->raw.size() > IMAGE_BANK_SIZE) {
+        fprintf(stderr, "%s has too many tiles\n", source.bmp);
+        return false;
+    }
+
+    printf("%s: %u tiles", source.bmp, (unsigned)tiles.size());
+    if (source.merge_tiles)
+        printf(", %u after merging", (unsigned)unique_tiles.size());
+    printf("\n");
+    return true;
+}
+
+// Returns the value of attribute |name| in the first |element| tag of |xml|.
+std::string getAttribute(const std::string& xml, const char* element,
+                         const char* name) {
+    size_t start = xml.find(std::string("<") + element + " ");
+    if (start == std::string::npos)
+        return "";
+    size_t end = xml.find('>', start);
+    std::string tag = xml.substr(start, end - start);
+    std::string key = std::string(" ") + name + "=\"";
+    size_t pos = tag.find(key);
+    if (pos == std::string::npos)
+        return "";
+    pos += key.size();
+    return tag.substr(pos, tag.find('"', pos) - pos);
+}
+
+bool decodeBase64(const std::string& text, Bytes* data) {
+    static const char kAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint32_t bits = 0;
+    int num_bits = 0;
+    data->clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '=' || isspace(c))
+            continue;
+        const char* digit = strchr(kAlphabet, c);
+        if (!digit || !c)
+            return false;
+        bits = (bits << 6) | (digit - kAlphabet);
+        num_bits += 6;
+        if (num_bits >= 8) {
+            num_bits -= 8;
+            data->push_back((bits >> num_bits) & 0xff);
+        }
+    }
+    return true;
+}
+
+// Inflates zlib or gzip data of a known size.
+bool inflateData(const Bytes& input, size_t size, Bytes* output) {
+    output->resize(size);
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 15 + 32) != Z_OK)
+        return false;
+    stream.next_in = const_cast<Bytef*>(input.data());
+    stream.avail_in = input.size();
+    stream.next_out = output->data();
+    stream.avail_out = size;
+    int result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && stream.avail_out == 0;
+}
+
+// Reads the tile numbers of the first layer of a map.
+bool readTMX(const char* filename, int* width, int* height,
+             std::vector<uint32_t>* tiles, uint32_t* first_gid,
+             std::string* image) {
+    Bytes file;
+    if (!readFile(getPath(filename), &file)) {
+        fprintf(stderr, "Could not read %s\n", filename);
+        return false;
+    }
+    std::string xml(file.begin(), file.end());
+    *width = atoi(getAttribute(xml, "layer", "width").c_str());
+    *height = atoi(getAttribute(xml, "layer", "height").c_str());
+    *first_gid = atoi(getAttribute(xml, "tileset", "firstgid").c_str());
+    *image = getAttribute(xml, "image", "source");
+    std::string encoding = getAttribute(xml, "data", "encoding");
+    std::string compression = getAttribute(xml, "data", "compression");
+
+    size_t start = xml.find("<data");
+    start = (start == std::string::npos) ? start : xml.find('>', start);
+    size_t end = xml.find("</data>");
+    if (start == std::string::npos || end == std::string::npos ||
+        *width <= 0 || *height <= 0) {
+        fprintf(stderr, "%s has no tile layer\n", filename);
+        return false;
+    }
+    std::string text = xml.substr(start + 1, end - start - 1);
+    size_t num_tiles = *width * *height;
+
+    tiles->clear();
+    if (encoding == "csv") {
+        const char* pos = text.c_str();
+        while (*pos) {
+            char* next;
+            unsigned long value = strtoul(pos, &next, 10);
+            if (next == pos) {
+                ++pos;
+                continue;
+            }
+            tiles->push_back(value);
+            pos = next;
+        }
+    } else if (encoding == "base64") {
+        Bytes data;
+        Bytes packed;
+        if (!decodeBase64(text, &packed)) {
+            fprintf(stderr, "%s has bad base64 data\n", filename);
+            return false;
+        }
+        if (compression.empty()) {
+            data.swap(packed);
+        } else if (!inflateData(packed, num_tiles * 4, &data)) {
+            fprintf(stderr, "%s has bad %s data\n", filename,
+                    compression.c_str());
+            return false;
+        }
+        for (size_t i = 0; i + 4 <= data.size(); i += 4)
+            tiles->push_back(readLE(data, i, 4));
+    } else {
+        fprintf(stderr, "%s uses unknown encoding %s\n", filename,
+                encoding.c_str());
+        return false;
+    }
+
+    if (tiles->size() != num_tiles) {
+        fprintf(stderr, "%s has %u tiles instead of %u\n", filename,
+                (unsigned)tiles->size(), (unsigned)num_tiles);
+        return false;
+    }
+    return true;
+}
+
+bool buildTilemap(const TilemapSource& source,
+                  const std::map<std::string, Tileset>& tilesets) {
+    int width = 0, height = 0;
+    std::vector<uint32_t> tiles;
+    uint32_t first_gid = 0;
+    std::string image;
+    if (!readTMX(source.tmx, &width, &height, &tiles, &first_gid, &image))
+        return false;
+    if (width > TILEMAP_WIDTH || height > TILEMAP_HEIGHT) {
+        fprintf(stderr, "%s is larger than %dx%d\n", source.tmx,
+                TILEMAP_WIDTH, TILEMAP_HEIGHT);
+        return false;
+    }
+    std::map<std::string, Tileset>::const_iterator it = tilesets.find(image);
+    if (it == tilesets.end()) {
+        fprintf(stderr, "%s uses %s, which is not built here\n", source.tmx,
+                image.c_str());
+        return false;
+    }
+    const std::vector<uint16_t>& remap = it->second.remap;
+
+    // Rows are TILEMAP_WIDTH entries apart.  Only the rows of the map are
+    // stored; the rest of the tilemap is left as it is.
+    Bytes lay(TILEMAP_WIDTH * height * sizeof(uint16_t));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < TILEMAP_WIDTH; ++x) {
+            uint16_t entry = kEmptyTile;
+            uint32_t gid = (x < width) ? tiles[y * width + x] & kTileNumberMask
+                                       : 0;
+            if (gid >= first_gid) {
+                if (gid - first_gid >= remap.size()) {
+                    fprintf(stderr, "%s uses tile %u, which is not in %s\n",
+                            source.tmx, (unsigned)gid, image.c_str());
+                    return false;
+                }
+                entry = remap[gid - first_gid];
+            }
+            size_t pos = (y * TILEMAP_WIDTH + x) * sizeof(uint16_t);
+            lay[pos] = entry & 0xff;
+            lay[pos + 1] = entry >> 8;
+        }
+    }
+
+    printf("%s: %dx%d tiles of %s\n", source.tmx, width, height,
+           image.c_str());
+    return writeWithHeader(source.lay, source.header, lay);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "--check") == 0) {
+        g_check = true;
+        ++arg;
+    }
+    if (arg < argc)
+        g_data_dir = argv[arg++];
+    if (arg < argc) {
+        fprintf(stderr, "Usage: %s [--check] [data_dir]\n", argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, Tileset> tilesets;
+    for (size_t i = 0; i < NUM_ELEMENTS(kTilesets); ++i) {
+        const TilesetSource& source = kTilesets[i];
+        Tileset& tileset = tilesets[source.bmp];
+        if (!buildTileset(source, &tileset) ||
+            !writeWithHeader(source.raw, source.raw_header, tileset.raw) ||
+            !writeWithHeader(source.pal, source.pal_header, tileset.pal)) {
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < NUM_ELEMENTS(kTilemaps); ++i) {
+        if (!buildTilemap(kTilemaps[i], tilesets))
+            return 1;
+    }
+
+    if (g_check && g_num_changed) {
+        printf("%d files are out of date\n", g_num_changed);
+        return 1;
+    }
+    return 0;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,252 @@
+//////////////////////////////////////////////////////////////////////////////////
+// BusBudget.cpp
+// - Plays scripted sessions on the simulated core and checks the bus traffic
+//   of each frame against a budget for its game state.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -Ihost -o bus_budget BusBudget.cpp CoreSim.cpp ../Game.cpp
+//       ../Screen.cpp ../Assets.cpp ../Video.cpp ../System.cpp ../Hud.cpp
+//       ../StateStack.cpp ../LandedSquares.cpp ../cBlock.cpp ../cSquare.cpp
+//       ../Log.cpp ../Profile.cpp
+//
+// Usage: bus_budget [<state>=<bytes>/<transactions> ...]
+//   Overrides the per-frame budget of a state, e.g. Game=300/40.  Exits with
+//   status 1 if any frame goes over the budget of its state.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CoreSim.h"
+#include "../Defines.h"
+#include "../Game.h"
+
+namespace {
+
+enum BenchState {
+    STATE_MENU,
+    STATE_GAME,
+    STATE_EXIT,
+    STATE_WON,
+    STATE_LOST,
+    NUM_STATES,
+};
+
+// Most payload bytes and transactions allowed in one frame of each state.
+struct Budget {
+    const char* name;
+    uint32_t bytes;
+    uint32_t transactions;
+};
+
+Budget g_budgets[NUM_STATES] = {
+    { "Menu",     128, 12 },
+    { "Game",     256, 40 },
+    { "Exit",     128, 12 },
+    { "GameWon",  128, 12 },
+    { "GameLost", 128, 12 },
+};
+
+// Gamepad input held for a number of frames.  The inputs of a session are
+// repeated until it ends.
+struct Input {
+    uint16_t buttons;
+    int16_t x, y;
+    int frames;
+};
+
+// The session goes through the states in this order.  Buttons that leave a
+// state are not pressed, since the states are called directly.
+struct Session {
+    BenchState state;
+    int frames;
+    const Input* inputs;
+    int num_inputs;
+};
+
+const Input kIdle[] = {
+    { 0, 0, 0, 1 },
+};
+
+// Moves each block around and drops it, so that blocks land, lines clear and
+// the game is eventually lost and restarted.
+const Input kPlay[] = {
+    { 0,  0,  0, 4 },
+    { 0,  0, -1, 1 },       // Rotate.
+    { 0,  0,  0, 1 },
+    { 0, -1,  0, 3 },
+    { 0,  0,  0, 2 },
+    { 0,  1,  0, 6 },
+    { 0,  0,  1, 20 },      // Drop.
+    { 0, -1,  0, 2 },
+    { 0,  0,  1, 20 },
+};
+
+#define NUM_INPUTS(inputs)  (int)(sizeof(inputs) / sizeof(inputs[0]))
+
+const Session kSessions[] = {
+    { STATE_MENU,   60, kIdle, NUM_INPUTS(kIdle) },
+    { STATE_GAME, 3000, kPlay, NUM_INPUTS(kPlay) },
+    { STATE_EXIT,   60, kIdle, NUM_INPUTS(kIdle) },
+    { STATE_WON,    60, kIdle, NUM_INPUTS(kIdle) },
+    { STATE_LOST,   60, kIdle, NUM_INPUTS(kIdle) },
+    { STATE_GAME,  600, kPlay, NUM_INPUTS(kPlay) },
+};
+
+struct StateStats {
+    uint32_t frames;
+    uint64_t bytes;
+    uint64_t transactions;
+    uint64_t spi_time_ns;
+    uint32_t max_bytes;
+    uint32_t max_transactions;
+    uint64_t max_spi_time_ns;
+    uint32_t frames_over_budget;
+};
+
+StateStats g_stats[NUM_STATES];
+
+const Input& getInput(const Session& session, int frame) {
+    int period = 0;
+    for (int i = 0; i < session.num_inputs; ++i)
+        period += session.inputs[i].frames;
+
+    frame %= period;
+    int i = 0;
+    while (frame >= session.inputs[i].frames) {
+        frame -= session.inputs[i].frames;
+        ++i;
+    }
+    return session.inputs[i];
+}
+
+void runState(FallingBlocksGame* game, BenchState state) {
+    switch (state) {
+    case STATE_MENU:
+        game->Menu();
+        break;
+    case STATE_GAME:
+        game->Game();
+        break;
+    case STATE_EXIT:
+        game->Exit();
+        break;
+    case STATE_WON:
+        game->GameWon();
+        break;
+    case STATE_LOST:
+        game->GameLost();
+        break;
+    default:
+        break;
+    }
+}
+
+// Runs one frame of |state|, followed by idle time.  The frame starts at the
+// beginning of a vblank, so the flip of the last frame happens on its first
+// poll and the frame's traffic does not depend on how long it waited.
+void runFrame(FallingBlocksGame* game, BenchState state, const Input& input) {
+    GamepadState gamepad;
+    gamepad.buttons = input.buttons;
+    gamepad.x = input.x;
+    gamepad.y = input.y;
+    CoreSim::SetGamepad(gamepad);
+
+    CoreSim::AdvanceTime((uint64_t)(FRAME_RATE) * 1000000);
+    CoreSim::AdvanceToVblank();
+
+    CoreSim::ResetStats();
+    runState(game, state);
+    const CoreSim::BusStats& bus = CoreSim::GetStats();
+
+    uint32_t bytes = bus.read_bytes + bus.write_bytes;
+    StateStats& stats = g_stats[state];
+    ++stats.frames;
+    stats.bytes += bytes;
+    stats.transactions += bus.transactions;
+    stats.spi_time_ns += bus.spi_time_ns;
+    if (bytes > stats.max_bytes)
+        stats.max_bytes = bytes;
+    if (bus.transactions > stats.max_transactions)
+        stats.max_transactions = bus.transactions;
+    if (bus.spi_time_ns > stats.max_spi_time_ns)
+        stats.max_spi_time_ns = bus.spi_time_ns;
+
+    const Budget& budget = g_budgets[state];
+    if (bytes > budget.bytes || bus.transactions > budget.transactions)
+        ++stats.frames_over_budget;
+
+    // The time left in the frame, which loads assets, is not measured.
+    game->Idle();
+}
+
+// Parses "<state>=<bytes>/<transactions>".
+bool parseBudget(const char* arg) {
+    char name[16];
+    unsigned bytes, transactions;
+    if (sscanf(arg, "%15[^=]=%u/%u", name, &bytes, &transactions) != 3)
+        return false;
+
+    for (int i = 0; i < NUM_STATES; ++i) {
+        if (strcmp(name, g_budgets[i].name) == 0) {
+            g_budgets[i].bytes = bytes;
+            g_budgets[i].transactions = transactions;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (!parseBudget(argv[i])) {
+            fprintf(stderr, "Usage: %s [<state>=<bytes>/<transactions> ...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    DC.begin();
+    FallingBlocksGame game;
+    game.Init();
+
+    // Loading is not part of any frame.
+    CoreSim::ResetStats();
+    for (int i = 0; i < NUM_INPUTS(kSessions); ++i) {
+        const Session& session = kSessions[i];
+        for (int frame = 0; frame < session.frames; ++frame)
+            runFrame(&game, session.state, getInput(session, frame));
+    }
+
+    printf("\n%-9s %7s %10s %9s %10s %9s %10s %9s\n", "state", "frames",
+           "avg bytes", "max bytes", "avg trans", "max trans", "max us",
+           "budget");
+    bool over_budget = false;
+    for (int i = 0; i < NUM_STATES; ++i) {
+        const StateStats& stats = g_stats[i];
+        if (stats.frames == 0)
+            continue;
+
+        printf("%-9s %7u %10.1f %9u %10.1f %9u %10.1f %5u/%-3u%s\n",
+               g_budgets[i].name, stats.frames,
+               (double)stats.bytes / stats.frames, stats.max_bytes,
+               (double)stats.transactions / stats.frames,
+               stats.max_transactions, stats.max_spi_time_ns / 1000.0,
+               g_budgets[i].bytes, g_budgets[i].transactions,
+               stats.frames_over_budget ? " OVER" : "");
+        if (stats.frames_over_budget) {
+            printf("  %u frames over budget\n", stats.frames_over_budget);
+            over_budget = true;
+        }
+    }
+
+    if (CoreSim::GetNumErrors()) {
+        printf("%u invalid core accesses\n", CoreSim::GetNumErrors());
+        return 1;
+    }
+    return over_budget ? 1 : 0;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////////
+// CompositeBench.cpp
+// - Measures the host compositing speed of each CompositeScanline() kernel,
+//   and of blitting from the tile atlas cache.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o composite_bench CompositeBench.cpp HostVideo.cpp TileAtlas.cpp
+//       TileComposite.cpp ../Screen.cpp ../Assets.cpp ../Hud.cpp ../cBlock.cpp
+//       ../cSquare.cpp ../LandedSquares.cpp ../Log.cpp Trace.cpp
+//
+// Each method is checked against the indexed framebuffer, then timed at the
+// native 320x240 and at larger integer scales.  The atlas cache is also checked
+// while palette colors are cycled.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../Hud.h"
+#include "../Screen.h"
+#include "../cBlock.h"
+#include "HostVideo.h"
+
+namespace {
+
+const int kScales[] = { 1, 2, 4 };
+const double kSecondsPerRun = 0.5;
+
+// Draws a frame of a game in progress.  The screen keeps pointing at the
+// blocks, so they outlive the call.
+void DrawFrame(Screen* screen) {
+    static const cBlock focus(BLOCK_START_X * SQUARE_SIZE,
+                              BLOCK_START_Y * SQUARE_SIZE, S_BLOCK);
+    static const cBlock next(NEXT_BLOCK_CIRCLE_X * SQUARE_SIZE,
+                             NEXT_BLOCK_CIRCLE_Y * SQUARE_SIZE, L_BLOCK);
+    Hud hud;
+    screen->DrawBackground(3);
+    screen->DrawBlocks(NULL, 0, &focus, &next);
+    hud.Draw(screen, 3, 13125, 3 * POINTS_PER_LEVEL);
+    screen->Update();
+    screen->PollFlip();
+}
+
+// Compares a native scale RGBA frame with the indexed framebuffer.
+bool MatchesFramebuffer(const std::vector<uint32_t>& pixels) {
+    const uint16_t* framebuffer = HostVideo::GetFramebuffer();
+    for (int i = 0; i < HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT; ++i) {
+        Video::Color color = HostVideo::GetColor(framebuffer[i]);
+        uint32_t expected;
+        memcpy(&expected, &color, sizeof(expected));
+        if (pixels[i] != expected)
+            return false;
+    }
+    return true;
+}
+
+// Times |render| at |scale| and prints the frame rate.
+template <typename RenderFunction>
+void TimeRender(const char* name, int scale, RenderFunction render) {
+    int width = HOST_SCREEN_WIDTH * scale;
+    int height = HOST_SCREEN_HEIGHT * scale;
+    std::vector<uint32_t> pixels(width * height);
+
+    int frames = 0;
+    double seconds = 0;
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    while (seconds < kSecondsPerRun) {
+        render(&pixels[0], scale);
+        ++frames;
+        seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+    printf("%-8s %4dx%-4d %8.0f frames/s %8.1f Mpixels/s\n",
+           name, width, height, frames / seconds,
+           frames / seconds * width * height / 1e6);
+}
+
+// Cycles colors of the blocks palette like the game does, and checks that the
+// atlas cache keeps up.
+bool CheckColorCycling() {
+    std::vector<uint32_t> expected(HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT);
+    std::vector<uint32_t> pixels(expected.size());
+    for (int step = 0; step < NUM_CYCLED_COLORS; ++step) {
+        for (int i = 0; i < NUM_CYCLED_COLORS; ++i) {
+            Video::Color color = { (uint8_t)(i * 32), (uint8_t)(step * 32),
+                                   (uint8_t)(255 - i * 32), 0 };
+            Video::SetPaletteEntry(UI_PALETTE_INDEX,
+                                   COLOR_CYCLING_START_INDEX +
+                                   (i + step) % NUM_CYCLED_COLORS,
+                                   color);
+        }
+        HostVideo::RenderRGBA(&expected[0], 1, COMPOSITE_KERNEL_SCALAR);
+        HostVideo::RenderRGBACached(&pixels[0], 1);
+        if (pixels != expected)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    static const struct {
+        CompositeKernel kernel;
+        const char* name;
+    } kKernels[] = {
+        { COMPOSITE_KERNEL_SCALAR, "scalar" },
+        { COMPOSITE_KERNEL_SSE2,   "sse2" },
+        { COMPOSITE_KERNEL_AVX2,   "avx2" },
+    };
+
+    Screen screen;
+    screen.Init();
+    screen.FinishLoading();
+    DrawFrame(&screen);
+    HostVideo::Render();
+
+    int result = 0;
+    for (size_t k = 0; k < sizeof(kKernels) / sizeof(kKernels[0]); ++k) {
+        if (!IsCompositeKernelSupported(kKernels[k].kernel)) {
+            printf("%-8s not supported\n", kKernels[k].name);
+            continue;
+        }
+
+        for (size_t s = 0; s < sizeof(kScales) / sizeof(kScales[0]); ++s) {
+            int scale = kScales[s];
+            std::vector<uint32_t> pixels(HOST_SCREEN_WIDTH *
+                                         HOST_SCREEN_HEIGHT * scale * scale);
+            HostVideo::RenderRGBA(&pixels[0], scale, kKernels[k].kernel);
+            if (scale == 1 && !MatchesFramebuffer(pixels)) {
+                printf("%-8s mismatch with the indexed framebuffer\n",
+                       kKernels[k].name);
+                result = 1;
+            }
+
+            TimeRender(kKernels[k].name, scale,
+                       [&](uint32_t* dest, int render_scale) {
+                           HostVideo::RenderRGBA(dest, render_scale,
+                                                 kKernels[k].kernel);
+                       });
+        }
+    }
+
+    for (size_t s = 0; s < sizeof(kScales) / sizeof(kScales[0]); ++s) {
+        int scale = kScales[s];
+        std::vector<uint32_t> pixels(HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT *
+                                     scale * scale);
+        HostVideo::RenderRGBACached(&pixels[0], scale);
+        if (scale == 1 && !MatchesFramebuffer(pixels)) {
+            printf("atlas    mismatch with the indexed framebuffer\n");
+            result = 1;
+        }
+        TimeRender("atlas", scale, HostVideo::RenderRGBACached);
+    }
+
+    if (!CheckColorCycling()) {
+        printf("atlas    mismatch after palette changes\n");
+        result = 1;
+    }
+    const TileAtlasCache::Stats& stats = HostVideo::GetAtlasStats();
+    printf("atlas    %u builds, %u refreshes of %llu pixels\n",
+           stats.builds, stats.refreshes,
+           (unsigned long long)stats.refreshed_pixels);
+
+    return result;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,358 @@
+//////////////////////////////////////////////////////////////////////////////////
+// CoreSim.cpp
+// - Implements the host DuinoCube and Arduino stand-ins, and the CoreSim
+//   functions.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "CoreSim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host/Arduino.h"
+
+DuinoCube DC;
+HardwareSerial Serial;
+
+namespace {
+
+#define MAX_OPEN_FILES      8
+
+// Display timing: 525 lines per 60 Hz frame, the last 45 of them in vblank.
+#define FRAME_TIME_NS       16683350ULL
+#define VBLANK_TIME_NS      (FRAME_TIME_NS * 45 / 525)
+
+// Cost of reading the clock, so that loops that only wait on it terminate.
+#define CLOCK_READ_NS       1000
+
+// Command header of each core transaction: an opcode and an address.
+#define COMMAND_HEADER_SIZE    3
+
+const CoreSim::SpiCost kDefaultCost = {
+    2000,       // transaction_ns
+    1000,       // byte_ns
+    5000,       // file_byte_ns
+};
+
+uint8_t g_unbanked[BANKED_MEM_BASE];
+uint8_t g_banks[CORE_SIM_NUM_BANKS][BANKED_MEM_SIZE];
+
+FILE* g_files[MAX_OPEN_FILES];
+
+const char* g_data_path = "../Data";
+CoreSim::SpiCost g_cost = kDefaultCost;
+GamepadState g_gamepad;
+FILE* g_serial_output = NULL;
+
+uint64_t g_time_ns = 0;
+CoreSim::BusStats g_stats;
+uint32_t g_num_errors = 0;
+
+uint16_t getRegister(uint16_t addr) {
+    return g_unbanked[addr] | (g_unbanked[addr + 1] << 8);
+}
+
+// Returns true if a tile layer is drawn from VRAM.
+bool isAnyLayerEnabled() {
+    for (int layer = 0; layer < CORE_SIM_NUM_TILE_LAYERS; ++layer) {
+        if (getRegister(TILE_LAYER_REG(layer, TILE_CTRL_0)) &
+            (1 << TILE_LAYER_ENABLED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the byte at |addr| with |bank| selected, or NULL if there is none.
+// VRAM is only there while the MCU has been given access to it, and taking
+// it away from the layers that are on screen would break up the picture.
+uint8_t* getByte(uint32_t addr, uint16_t bank) {
+    if (addr < BANKED_MEM_BASE)
+        return &g_unbanked[addr];
+    if (addr >= BANKED_MEM_BASE + BANKED_MEM_SIZE || bank >= CORE_SIM_NUM_BANKS)
+        return NULL;
+    if (bank >= VRAM_BANK_BEGIN &&
+        (!(getRegister(REG_SYS_CTRL) & (1 << REG_SYS_CTRL_VRAM_ACCESS)) ||
+         isAnyLayerEnabled())) {
+        return NULL;
+    }
+    return &g_banks[bank][addr - BANKED_MEM_BASE];
+}
+
+// Reads or writes core memory through the banked window.  Bytes that fall
+// outside the modeled memory are counted as one error per access.
+void readMemory(uint16_t addr, void* data, uint16_t size) {
+    uint16_t bank = getRegister(REG_MEM_BANK);
+    uint8_t* dest = static_cast<uint8_t*>(data);
+    bool error = false;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint8_t* byte = getByte(addr + i, bank);
+        if (!byte)
+            error = true;
+        dest[i] = byte ? *byte : 0;
+    }
+    if (error)
+        ++g_num_errors;
+}
+
+void writeMemory(uint16_t addr, const void* data, uint16_t size) {
+    uint16_t bank = getRegister(REG_MEM_BANK);
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    bool error = false;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint8_t* byte = getByte(addr + i, bank);
+        if (byte)
+            *byte = src[i];
+        else
+            error = true;
+    }
+    if (error)
+        ++g_num_errors;
+}
+
+uint16_t getOutputStatus() {
+    bool vblank = (g_time_ns % FRAME_TIME_NS) >= FRAME_TIME_NS - VBLANK_TIME_NS;
+    return vblank ? (1 << REG_VBLANK) : 0;
+}
+
+// Counts one transaction on the bus and advances the clock by its cost.
+void countTransaction(uint32_t read_bytes, uint32_t write_bytes) {
+    uint64_t time = g_cost.transaction_ns +
+        (uint64_t)(COMMAND_HEADER_SIZE + read_bytes + write_bytes) *
+        g_cost.byte_ns;
+    ++g_stats.transactions;
+    g_stats.read_bytes += read_bytes;
+    g_stats.write_bytes += write_bytes;
+    g_stats.spi_time_ns += time;
+    g_time_ns += time;
+}
+
+// Counts file data read by the coprocessor.
+void countFileRead(uint32_t size) {
+    g_stats.file_bytes += size;
+    g_time_ns += (uint64_t)size * g_cost.file_byte_ns;
+}
+
+FILE* getFile(uint16_t handle) {
+    if (handle == 0 || handle > MAX_OPEN_FILES || !g_files[handle - 1]) {
+        ++g_num_errors;
+        return NULL;
+    }
+    return g_files[handle - 1];
+}
+
+}  // namespace
+
+void DuinoCube::begin() {
+    CoreSim::Reset();
+}
+
+uint16_t DuinoCubeCore::readWord(uint16_t addr) {
+    countTransaction(sizeof(uint16_t), 0);
+    if (addr == REG_OUTPUT_STATUS)
+        return getOutputStatus();
+
+    uint8_t data[2];
+    readMemory(addr, data, sizeof(data));
+    return data[0] | (data[1] << 8);
+}
+
+void DuinoCubeCore::writeWord(uint16_t addr, uint16_t value) {
+    countTransaction(0, sizeof(uint16_t));
+    uint8_t data[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+    writeMemory(addr, data, sizeof(data));
+}
+
+void DuinoCubeCore::readData(uint16_t addr, void* data, uint16_t size) {
+    countTransaction(size, 0);
+    readMemory(addr, data, size);
+}
+
+void DuinoCubeCore::writeData(uint16_t addr, const void* data, uint16_t size) {
+    countTransaction(0, size);
+    writeMemory(addr, data, size);
+}
+
+uint16_t DuinoCubeFile::open(const char* path, uint16_t mode) {
+    countTransaction(sizeof(uint16_t), strlen(path) + 1);
+
+    int index = 0;
+    while (index < MAX_OPEN_FILES && g_files[index])
+        ++index;
+    if (index == MAX_OPEN_FILES)
+        return 0;
+
+    // Drop the directory; all data files are in one host directory.
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    char host_path[256];
+    snprintf(host_path, sizeof(host_path), "%s/%s", g_data_path, name);
+    g_files[index] = fopen(host_path, "rb");
+    return g_files[index] ? index + 1 : 0;
+}
+
+void DuinoCubeFile::close(uint16_t handle) {
+    countTransaction(0, sizeof(handle));
+    FILE* file = getFile(handle);
+    if (!file)
+        return;
+    fclose(file);
+    g_files[handle - 1] = NULL;
+}
+
+uint16_t DuinoCubeFile::size(uint16_t handle) {
+    countTransaction(sizeof(uint16_t), sizeof(handle));
+    FILE* file = getFile(handle);
+    if (!file)
+        return 0;
+
+    long pos = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, pos, SEEK_SET);
+    return (size > 0xffff) ? 0xffff : size;
+}
+
+uint16_t DuinoCubeFile::read(uint16_t handle, void* data, uint16_t size) {
+    FILE* file = getFile(handle);
+    uint16_t num_read = file ? fread(data, 1, size, file) : 0;
+    countTransaction(num_read, sizeof(handle) + sizeof(size));
+    countFileRead(num_read);
+    return num_read;
+}
+
+uint16_t DuinoCubeFile::readToCore(uint16_t handle, uint16_t addr,
+                                   uint16_t size) {
+    // Only the command goes over the bus.  The coprocessor copies the data.
+    countTransaction(sizeof(uint16_t),
+                     sizeof(handle) + sizeof(addr) + sizeof(size));
+    FILE* file = getFile(handle);
+    if (!file)
+        return 0;
+
+    uint8_t buffer[256];
+    uint16_t total = 0;
+    while (total < size) {
+        uint16_t chunk = size - total;
+        if (chunk > sizeof(buffer))
+            chunk = sizeof(buffer);
+        uint16_t num_read = fread(buffer, 1, chunk, file);
+        writeMemory(addr + total, buffer, num_read);
+        total += num_read;
+        if (num_read < chunk)
+            break;
+    }
+    countFileRead(total);
+    return total;
+}
+
+GamepadState DuinoCubeGamepad::readGamepad() {
+    countTransaction(sizeof(GamepadState), 0);
+    return g_gamepad;
+}
+
+uint32_t millis() {
+    g_time_ns += CLOCK_READ_NS;
+    return g_time_ns / 1000000;
+}
+
+uint32_t micros() {
+    g_time_ns += CLOCK_READ_NS;
+    return g_time_ns / 1000;
+}
+
+void delay(uint32_t ms) {
+    g_time_ns += (uint64_t)ms * 1000000;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t size) {
+    if (g_serial_output)
+        fwrite(data, 1, size, g_serial_output);
+    return size;
+}
+
+namespace CoreSim {
+
+    void Reset() {
+        memset(g_unbanked, 0, sizeof(g_unbanked));
+        memset(g_banks, 0, sizeof(g_banks));
+        for (int i = 0; i < MAX_OPEN_FILES; ++i) {
+            if (g_files[i])
+                fclose(g_files[i]);
+            g_files[i] = NULL;
+        }
+        memset(&g_gamepad, 0, sizeof(g_gamepad));
+        g_time_ns = 0;
+        g_num_errors = 0;
+        ResetStats();
+    }
+
+    void SetDataPath(const char* path) {
+        g_data_path = path;
+    }
+
+    void SetSpiCost(const SpiCost& cost) {
+        g_cost = cost;
+    }
+
+    void SetSerialOutput(FILE* file) {
+        g_serial_output = file;
+    }
+
+    void SetGamepad(const GamepadState& state) {
+        g_gamepad = state;
+    }
+
+    uint64_t GetTimeNs() {
+        return g_time_ns;
+    }
+
+    void AdvanceTime(uint64_t ns) {
+        g_time_ns += ns;
+    }
+
+    void AdvanceToVblank() {
+        uint64_t start = FRAME_TIME_NS - VBLANK_TIME_NS;
+        uint64_t frame_time = g_time_ns % FRAME_TIME_NS;
+        if (frame_time < start)
+            g_time_ns += start - frame_time;
+        else
+            g_time_ns += FRAME_TIME_NS - frame_time + start;
+    }
+
+    const BusStats& GetStats() {
+        return g_stats;
+    }
+
+    void ResetStats() {
+        memset(&g_stats, 0, sizeof(g_stats));
+    }
+
+    uint32_t GetNumErrors() {
+        return g_num_errors;
+    }
+
+    void Peek(uint16_t addr, uint16_t bank, void* data, uint16_t size) {
+        uint8_t* dest = static_cast<uint8_t*>(data);
+        for (uint32_t i = 0; i < size; ++i) {
+            uint32_t byte_addr = addr + i;
+            if (byte_addr < BANKED_MEM_BASE)
+                dest[i] = g_unbanked[byte_addr];
+            else if (byte_addr < BANKED_MEM_BASE + BANKED_MEM_SIZE &&
+                     bank < CORE_SIM_NUM_BANKS)
+                dest[i] = g_banks[bank][byte_addr - BANKED_MEM_BASE];
+            else
+                dest[i] = 0;
+        }
+    }
+
+    uint16_t PeekWord(uint16_t addr, uint16_t bank) {
+        uint8_t data[2];
+        Peek(addr, bank, data, sizeof(data));
+        return data[0] | (data[1] << 8);
+    }
+
+}  // namespace CoreSim
+
+//  Simon Que, 2013 //
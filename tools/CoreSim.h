@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////////
+// CoreSim.h
+// - Simulated DuinoCube core, with accounting of the traffic on its bus.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "host/DuinoCube.h"
+
+// Number of memory banks behind the banked window.
+#define CORE_SIM_NUM_BANKS   (VRAM_BANK_BEGIN + VRAM_NUM_BANKS)
+
+// Number of tile layers, which draw from VRAM while they are enabled.
+#define CORE_SIM_NUM_TILE_LAYERS   4
+
+// Link tools/CoreSim.cpp with tools/host on the include path to run Video.cpp
+// and System.cpp on the host.  DC.Core reads and writes an in-memory register
+// file, palettes and banks, with the banked window switched by REG_MEM_BANK
+// and VRAM only reachable while REG_SYS_CTRL_VRAM_ACCESS is set and no tile
+// layer is enabled, since the layers can't draw without it.  DC.File reads
+// host files.  Every call that goes over the SPI bus is counted and advances
+// the simulated clock by its cost.
+namespace CoreSim {
+
+    struct BusStats {
+        uint32_t transactions;
+        uint32_t read_bytes;        // Payload bytes, without command headers.
+        uint32_t write_bytes;
+        uint32_t file_bytes;        // Copied by DC.File.readToCore().
+        uint64_t spi_time_ns;       // Time spent on the bus.
+    };
+
+    // Cost of bus traffic.  The default is an 8 MHz SPI clock, a three byte
+    // command header and some chip select overhead per transaction, and a
+    // coprocessor that reads files from the SD card at 200 KB/s.
+    struct SpiCost {
+        uint32_t transaction_ns;
+        uint32_t byte_ns;
+        uint32_t file_byte_ns;
+    };
+
+    // Clears memory, statistics, open files and the clock.
+    void Reset();
+
+    // Files opened as "<dir>/<name>" are read from "<path>/<name>".  The
+    // default is "../Data".
+    void SetDataPath(const char* path);
+
+    void SetSpiCost(const SpiCost& cost);
+
+    // Bytes written to Serial go to |file|, or are dropped if it is NULL.
+    void SetSerialOutput(FILE* file);
+
+    // Sets what DC.Gamepad.readGamepad() returns.
+    void SetGamepad(const GamepadState& state);
+
+    // Simulated time.  REG_OUTPUT_STATUS reports vblank for the last 45 of
+    // 525 lines of each 60 Hz frame.
+    uint64_t GetTimeNs();
+    void AdvanceTime(uint64_t ns);
+
+    // Advances the clock to the start of the next vblank.
+    void AdvanceToVblank();
+
+    const BusStats& GetStats();
+    void ResetStats();
+
+    // Number of accesses outside the modeled memory, of VRAM accesses while
+    // the MCU does not own VRAM, and of calls with invalid file handles.
+    uint32_t GetNumErrors();
+
+    // Reads core memory at |addr| as if |bank| were selected, without going
+    // over the bus.
+    void Peek(uint16_t addr, uint16_t bank, void* data, uint16_t size);
+    uint16_t PeekWord(uint16_t addr, uint16_t bank);
+}
+
+//  Simon Que, 2013 //
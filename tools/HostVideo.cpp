@@ -0,0 +1,553 @@
+//////////////////////////////////////////////////////////////////////////////////
+// HostVideo.cpp
+// - Implements the Video and HostVideo functions on the host.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "HostVideo.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Trace.h"
+
+namespace {
+
+#define NUM_LAYERS      4
+
+// Each tilemap row is 64 bytes, whatever the size of its entries.
+#define TILEMAP_PITCH   (TILEMAP_WIDTH * sizeof(uint16_t))
+#define TILEMAP_BYTES   (TILEMAP_PITCH * TILEMAP_HEIGHT)
+
+struct Layer {
+    uint16_t flags;
+    uint8_t palette;
+    uint16_t data_offset;
+    uint16_t empty_value;
+    uint8_t color_key;
+    uint16_t scroll_x, scroll_y;
+    uint8_t tilemap[TILEMAP_BYTES];
+};
+
+Layer g_layers[NUM_LAYERS];
+Video::Color g_palettes[NUM_PALETTES][PALETTE_NUM_COLORS];
+uint8_t g_vram[HOST_VRAM_SIZE];
+uint32_t g_vram_end = 0;
+uint8_t g_reserved[RESERVED_MEM_SIZE];
+
+uint16_t g_framebuffer[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+
+const char* g_data_path = "../Data";
+bool g_vblank = true;
+
+// Files opened with Video::OpenFile().  A handle is an index plus one.
+#define MAX_OPEN_FILES  8
+FILE* g_files[MAX_OPEN_FILES];
+
+// Images in VRAM with their palette colors looked up.
+TileAtlasCache g_atlas(g_vram, &g_palettes[0][0]);
+
+// Image being written in pieces by Video::WriteImage() or
+// Video::ReadFileToImage().  It is added to the atlas cache once it is
+// complete, which is known when the next write does not continue it or when
+// the cache is next used.
+uint32_t g_written_image_offset = 0;
+uint32_t g_written_image_size = 0;
+
+void addWrittenImage() {
+    if (g_written_image_size)
+        g_atlas.AddImage(g_written_image_offset, g_written_image_size);
+    g_written_image_size = 0;
+}
+
+// Returns true if an image of |size| bytes at |vram_offset| is in one bank
+// and ends before the skip buffer, as on the DuinoCube.
+bool isValidImage(uint16_t vram_offset, uint32_t size) {
+    return vram_offset % IMAGE_BANK_SIZE + size <= IMAGE_BANK_SIZE &&
+           vram_offset + size <= IMAGE_VRAM_END;
+}
+
+void onImageWritten(uint16_t vram_offset, uint16_t size) {
+    if ((uint32_t)vram_offset + size > g_vram_end)
+        g_vram_end = vram_offset + size;
+
+    if (g_written_image_size &&
+        vram_offset == g_written_image_offset + g_written_image_size) {
+        g_written_image_size += size;
+        return;
+    }
+    addWrittenImage();
+    g_written_image_offset = vram_offset;
+    g_written_image_size = size;
+}
+
+// Reads a whole data file into |dest|.  Returns the file size, or -1 if the
+// file could not be read or is larger than |max_size|.
+int readFile(const char* filename, void* dest, uint32_t max_size) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", g_data_path, filename);
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Could not open file %s.\n", path);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0 || (uint32_t)size > max_size) {
+        printf("File %s is too big!\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    size_t num_read = fread(dest, 1, size, file);
+    fclose(file);
+    return (num_read == (size_t)size) ? size : -1;
+}
+
+FILE* getFile(uint16_t handle) {
+    if (handle == 0 || handle > MAX_OPEN_FILES)
+        return NULL;
+    return g_files[handle - 1];
+}
+
+// Reads |size| bytes from an open file into |dest|.
+bool readFromFile(uint16_t handle, void* dest, uint16_t size) {
+    FILE* file = getFile(handle);
+    return file && fread(dest, 1, size, file) == size;
+}
+
+// The part of one tile that falls on a scanline.
+struct TileSpan {
+    int x;              // First screen pixel.
+    int size;           // Number of pixels.
+    bool covered;       // False for NOP tiles.
+    uint16_t addr;      // VRAM address of the first pixel.
+};
+
+// Most spans are on a scanline when 8x8 tiles are not aligned to the screen.
+#define MAX_TILE_SPANS  (HOST_SCREEN_WIDTH / 8 + 1)
+
+// Splits scanline |y| of a layer into tile spans.  Each tile row is contiguous
+// in VRAM.  Returns the number of spans.
+int getTileSpans(const Layer& layer, int y, TileSpan* spans) {
+    int tile_size = (layer.flags & Video::LAYER_8x8) ? 8 : 16;
+    int entry_size = (layer.flags & Video::LAYER_8_BIT) ? 1 : 2;
+    int map_width = TILEMAP_PITCH / entry_size * tile_size;
+    int map_height = TILEMAP_HEIGHT * tile_size;
+    bool use_nop = layer.flags & Video::LAYER_NOP;
+
+    int map_y = (y + layer.scroll_y) % map_height;
+    const uint8_t* row = layer.tilemap + (map_y / tile_size) * TILEMAP_PITCH;
+    int tile_row_offset = (map_y % tile_size) * tile_size;
+
+    int num_spans = 0;
+    int x = 0;
+    while (x < HOST_SCREEN_WIDTH) {
+        int map_x = (x + layer.scroll_x) % map_width;
+        int column = map_x / tile_size;
+        int tile_x = map_x % tile_size;
+
+        TileSpan& span = spans[num_spans++];
+        span.x = x;
+        span.size = tile_size - tile_x;
+        if (span.size > HOST_SCREEN_WIDTH - x)
+            span.size = HOST_SCREEN_WIDTH - x;
+
+        uint16_t entry = row[column * entry_size];
+        if (entry_size == 2)
+            entry |= row[column * entry_size + 1] << 8;
+        span.covered = !use_nop || entry != layer.empty_value;
+        span.addr = layer.data_offset + entry * tile_size * tile_size +
+                    tile_row_offset + tile_x;
+        x += span.size;
+    }
+    return num_spans;
+}
+
+// Fetches the color indexes of one scanline of a layer, before the color key
+// is applied.  |covered| is set to zero for pixels of NOP tiles.
+void fetchScanline(const Layer& layer, int y, uint8_t* colors,
+                   uint8_t* covered) {
+    TileSpan spans[MAX_TILE_SPANS];
+    int num_spans = getTileSpans(layer, y, spans);
+    for (int i = 0; i < num_spans; ++i) {
+        const TileSpan& span = spans[i];
+        memset(covered + span.x, span.covered, span.size);
+        if (!span.covered)
+            continue;
+        if (span.addr + span.size <= HOST_VRAM_SIZE) {
+            memcpy(colors + span.x, g_vram + span.addr, span.size);
+        } else {
+            for (int j = 0; j < span.size; ++j)
+                colors[span.x + j] = g_vram[(uint16_t)(span.addr + j)];
+        }
+    }
+}
+
+// Draws one scanline of a layer from the atlas cache.  Tile rows without the
+// color key are copied whole.
+void drawScanlineFromAtlas(const Layer& layer, int y, uint32_t* line) {
+    bool use_color_key = layer.flags & Video::LAYER_TRANSPARENT;
+    const Video::Color* palette = g_palettes[layer.palette];
+
+    TileSpan spans[MAX_TILE_SPANS];
+    int num_spans = getTileSpans(layer, y, spans);
+    for (int i = 0; i < num_spans; ++i) {
+        const TileSpan& span = spans[i];
+        if (!span.covered)
+            continue;
+
+        const uint8_t* pixels = g_vram + span.addr;
+        const uint32_t* colors = NULL;
+        if (span.addr + span.size <= HOST_VRAM_SIZE)
+            colors = g_atlas.Lookup(span.addr, span.size, layer.palette);
+        uint32_t* dest = line + span.x;
+
+        if (colors &&
+            (!use_color_key || !memchr(pixels, layer.color_key, span.size))) {
+            memcpy(dest, colors, span.size * sizeof(*dest));
+            continue;
+        }
+        for (int j = 0; j < span.size; ++j) {
+            uint8_t color = g_vram[(uint16_t)(span.addr + j)];
+            if (use_color_key && color == layer.color_key)
+                continue;
+            if (colors)
+                dest[j] = colors[j];
+            else
+                memcpy(&dest[j], &palette[color], sizeof(dest[j]));
+        }
+    }
+}
+
+// Writes a composited scanline to row |y| of a |scale| times larger image,
+// repeating each pixel and then the whole row.
+void writeScaledLine(const uint32_t* line, int y, int scale, uint32_t* dest) {
+    int dest_width = HOST_SCREEN_WIDTH * scale;
+    uint32_t* row = dest + y * scale * dest_width;
+    if (scale == 1) {
+        memcpy(row, line, HOST_SCREEN_WIDTH * sizeof(*row));
+        return;
+    }
+    for (int x = 0; x < HOST_SCREEN_WIDTH; ++x) {
+        for (int i = 0; i < scale; ++i)
+            row[x * scale + i] = line[x];
+    }
+    for (int i = 1; i < scale; ++i)
+        memcpy(row + i * dest_width, row, dest_width * sizeof(*row));
+}
+
+// Color of pixels that no layer covers.
+uint32_t getBackgroundColor() {
+    uint32_t background;
+    memcpy(&background, &g_palettes[0][0], sizeof(background));
+    return background;
+}
+
+// Draws one layer over what is already in the framebuffer.
+void renderLayer(const Layer& layer) {
+    bool use_color_key = layer.flags & Video::LAYER_TRANSPARENT;
+    uint16_t palette_base = layer.palette * PALETTE_NUM_COLORS;
+
+    uint8_t colors[HOST_SCREEN_WIDTH];
+    uint8_t covered[HOST_SCREEN_WIDTH];
+    for (int y = 0; y < HOST_SCREEN_HEIGHT; ++y) {
+        fetchScanline(layer, y, colors, covered);
+        uint16_t* dest = g_framebuffer + y * HOST_SCREEN_WIDTH;
+        for (int x = 0; x < HOST_SCREEN_WIDTH; ++x) {
+            if (!covered[x])
+                continue;
+            if (use_color_key && colors[x] == layer.color_key)
+                continue;
+            dest[x] = palette_base + colors[x];
+        }
+    }
+}
+
+}  // namespace
+
+namespace Video {
+
+    bool Init() {
+        memset(g_layers, 0, sizeof(g_layers));
+        memset(g_palettes, 0, sizeof(g_palettes));
+        memset(g_vram, 0, sizeof(g_vram));
+        memset(g_reserved, 0, sizeof(g_reserved));
+        g_vram_end = 0;
+        g_written_image_size = 0;
+        g_atlas.Clear();
+        return true;
+    }
+
+    bool LoadTilemap(int layer, const char* filename) {
+        return readFile(filename, g_layers[layer].tilemap, TILEMAP_BYTES) >= 0;
+    }
+
+    bool LoadPalette(int palette, const char* filename) {
+        if (readFile(filename, g_palettes[palette],
+                     sizeof(g_palettes[palette])) < 0) {
+            return false;
+        }
+        g_atlas.OnPaletteChanged(palette);
+        return true;
+    }
+
+    bool LoadImage(const char* filename, uint16_t* vram_offset) {
+        int size = readFile(filename, g_vram + g_vram_end,
+                            IMAGE_VRAM_END - g_vram_end);
+        if (size < 0)
+            return false;
+        *vram_offset = g_vram_end;
+        g_atlas.AddImage(g_vram_end, size);
+        g_vram_end += size;
+        return true;
+    }
+
+    uint16_t OpenFile(const char* filename, uint16_t* size) {
+        int index = 0;
+        while (index < MAX_OPEN_FILES && g_files[index])
+            ++index;
+        if (index == MAX_OPEN_FILES)
+            return 0;
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s", g_data_path, filename);
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            printf("Could not open file %s.\n", path);
+            return 0;
+        }
+        fseek(file, 0, SEEK_END);
+        long file_size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        *size = (file_size > 0xffff) ? 0xffff : file_size;
+
+        g_files[index] = file;
+        return index + 1;
+    }
+
+    void CloseFile(uint16_t handle) {
+        FILE* file = getFile(handle);
+        if (!file)
+            return;
+        fclose(file);
+        g_files[handle - 1] = NULL;
+    }
+
+    uint16_t ReadFile(uint16_t handle, void* data, uint16_t size) {
+        FILE* file = getFile(handle);
+        return file ? fread(data, 1, size, file) : 0;
+    }
+
+    bool ReadFileToTilemap(uint16_t handle, int layer, uint16_t size) {
+        return size <= TILEMAP_BYTES &&
+               readFromFile(handle, g_layers[layer].tilemap, size);
+    }
+
+    bool ReadFileToPalette(uint16_t handle, int palette, uint16_t size) {
+        if (size > sizeof(g_palettes[palette]) ||
+            !readFromFile(handle, g_palettes[palette], size)) {
+            return false;
+        }
+        g_atlas.OnPaletteChanged(palette);
+        return true;
+    }
+
+    bool ReadFileToImage(uint16_t handle, uint16_t vram_offset, uint16_t size) {
+        if (!isValidImage(vram_offset, size) ||
+            !readFromFile(handle, g_vram + vram_offset, size)) {
+            return false;
+        }
+        onImageWritten(vram_offset, size);
+        return true;
+    }
+
+    void KeepImage(uint16_t vram_offset, uint16_t size) {
+        if (!isValidImage(vram_offset, size))
+            return;
+        g_atlas.AddImage(vram_offset, size);
+        if ((uint32_t)vram_offset + size > g_vram_end)
+            g_vram_end = vram_offset + size;
+    }
+
+    bool SkipFile(uint16_t handle, uint16_t size) {
+        FILE* file = getFile(handle);
+        if (!file)
+            return false;
+        long pos = ftell(file);
+        fseek(file, 0, SEEK_END);
+        long end = ftell(file);
+        if (pos < 0 || end - pos < size)
+            return false;
+        return fseek(file, pos + size, SEEK_SET) == 0;
+    }
+
+    void SetLayer(int layer, uint16_t flags, int palette) {
+        g_layers[layer].flags = flags;
+        g_layers[layer].palette = palette;
+    }
+
+    void SetLayerDataOffset(int layer, uint16_t vram_offset) {
+        g_layers[layer].data_offset = vram_offset;
+    }
+
+    void SetLayerEmptyValue(int layer, uint16_t value) {
+        g_layers[layer].empty_value = value;
+    }
+
+    void SetLayerColorKey(int layer, uint8_t color_key) {
+        g_layers[layer].color_key = color_key;
+    }
+
+    void SetLayerScroll(int layer, uint16_t x, uint16_t y) {
+        g_layers[layer].scroll_x = x;
+        g_layers[layer].scroll_y = y;
+    }
+
+    void SetPaletteEntry(int palette, int index, const Color& color) {
+        g_palettes[palette][index] = color;
+        g_atlas.OnPaletteEntryChanged(palette, index);
+    }
+
+    void ReadPalette(int palette, int index, Color* colors, int count) {
+        memcpy(colors, &g_palettes[palette][index], count * sizeof(*colors));
+    }
+
+    void WritePalette(int palette, int index, const Color* colors, int count) {
+        memcpy(&g_palettes[palette][index], colors, count * sizeof(*colors));
+        for (int i = 0; i < count; ++i)
+            g_atlas.OnPaletteEntryChanged(palette, index + i);
+    }
+
+    void WriteTilemap(int layer, uint16_t offset, const void* data,
+                      uint16_t size) {
+        if (offset >= TILEMAP_BYTES)
+            return;
+        if (size > TILEMAP_BYTES - offset)
+            size = TILEMAP_BYTES - offset;
+        memcpy(g_layers[layer].tilemap + offset, data, size);
+    }
+
+    void WriteImage(uint16_t vram_offset, const void* data, uint16_t size) {
+        if (!isValidImage(vram_offset, size))
+            return;
+        memcpy(g_vram + vram_offset, data, size);
+        onImageWritten(vram_offset, size);
+    }
+
+    void ReadReserved(uint16_t offset, void* data, uint16_t size) {
+        if (offset + size <= RESERVED_MEM_SIZE)
+            memcpy(data, g_reserved + offset, size);
+    }
+
+    void WriteReserved(uint16_t offset, const void* data, uint16_t size) {
+        if (offset + size <= RESERVED_MEM_SIZE)
+            memcpy(g_reserved + offset, data, size);
+    }
+
+    bool IsVblank() {
+        return g_vblank;
+    }
+
+}  // namespace Video
+
+namespace HostVideo {
+
+    void SetDataPath(const char* path) {
+        g_data_path = path;
+    }
+
+    void SetVblank(bool vblank) {
+        g_vblank = vblank;
+    }
+
+    void Render() {
+        TRACE_SCOPE("render", "frame");
+        memset(g_framebuffer, 0, sizeof(g_framebuffer));
+        for (int i = 0; i < NUM_LAYERS; ++i) {
+            if (g_layers[i].flags & Video::LAYER_ENABLED)
+                renderLayer(g_layers[i]);
+        }
+    }
+
+    void RenderRGBA(uint32_t* dest, int scale, CompositeKernel kernel) {
+        TRACE_SCOPE("render", "frame");
+        uint8_t colors[NUM_LAYERS][HOST_SCREEN_WIDTH];
+        uint8_t covered[NUM_LAYERS][HOST_SCREEN_WIDTH];
+        uint32_t line[HOST_SCREEN_WIDTH];
+        uint32_t background = getBackgroundColor();
+
+        for (int y = 0; y < HOST_SCREEN_HEIGHT; ++y) {
+            ScanlineLayer layers[NUM_LAYERS];
+            int num_layers = 0;
+            for (int i = 0; i < NUM_LAYERS; ++i) {
+                const Layer& layer = g_layers[i];
+                if (!(layer.flags & Video::LAYER_ENABLED))
+                    continue;
+                fetchScanline(layer, y, colors[i], covered[i]);
+
+                ScanlineLayer& scanline = layers[num_layers++];
+                scanline.colors = colors[i];
+                scanline.covered = covered[i];
+                scanline.palette = reinterpret_cast<const uint32_t*>(
+                        g_palettes[layer.palette]);
+                scanline.color_key = layer.color_key;
+                scanline.use_color_key =
+                        layer.flags & Video::LAYER_TRANSPARENT;
+            }
+
+            for (int x = 0; x < HOST_SCREEN_WIDTH; ++x)
+                line[x] = background;
+            CompositeScanline(layers, num_layers, HOST_SCREEN_WIDTH, line,
+                              kernel);
+            writeScaledLine(line, y, scale, dest);
+        }
+    }
+
+    void RenderRGBACached(uint32_t* dest, int scale) {
+        TRACE_SCOPE("render", "frame");
+        addWrittenImage();
+
+        uint32_t line[HOST_SCREEN_WIDTH];
+        uint32_t background = getBackgroundColor();
+        for (int y = 0; y < HOST_SCREEN_HEIGHT; ++y) {
+            for (int x = 0; x < HOST_SCREEN_WIDTH; ++x)
+                line[x] = background;
+            for (int i = 0; i < NUM_LAYERS; ++i) {
+                if (g_layers[i].flags & Video::LAYER_ENABLED)
+                    drawScanlineFromAtlas(g_layers[i], y, line);
+            }
+            writeScaledLine(line, y, scale, dest);
+        }
+    }
+
+    const TileAtlasCache::Stats& GetAtlasStats() {
+        return g_atlas.GetStats();
+    }
+
+    const uint16_t* GetFramebuffer() {
+        return g_framebuffer;
+    }
+
+    Video::Color GetColor(uint16_t pixel) {
+        return g_palettes[pixel / PALETTE_NUM_COLORS % NUM_PALETTES]
+                         [pixel % PALETTE_NUM_COLORS];
+    }
+
+    bool WritePPM(const char* path) {
+        FILE* file = fopen(path, "wb");
+        if (!file)
+            return false;
+        fprintf(file, "P6\n%d %d\n255\n", HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+        for (int i = 0; i < HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT; ++i) {
+            Video::Color color = GetColor(g_framebuffer[i]);
+            uint8_t rgb[3] = { color.r, color.g, color.b };
+            fwrite(rgb, 1, sizeof(rgb), file);
+        }
+        return fclose(file) == 0;
+    }
+
+}  // namespace HostVideo
+
+//  Simon Que, 2013 //
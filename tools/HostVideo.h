@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////////
+// HostVideo.h
+// - Host implementation of the Video interface, drawing into memory.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../Defines.h"
+#include "../Video.h"
+#include "TileAtlas.h"
+#include "TileComposite.h"
+
+// Size of the composited screen.
+#define HOST_SCREEN_WIDTH    WINDOW_WIDTH
+#define HOST_SCREEN_HEIGHT   WINDOW_HEIGHT
+
+// Size of the emulated video memory.
+#define HOST_VRAM_SIZE       0x10000
+
+// Link tools/HostVideo.cpp instead of Video.cpp to run Screen on the host.  The
+// Video calls update the emulated registers, palettes, tilemaps and VRAM, and
+// Render() composites the tile layers from them like the DuinoCube does.
+namespace HostVideo {
+
+    // Directory that data files are read from.  The default is "../Data".
+    void SetDataPath(const char* path);
+
+    // Sets the value that Video::IsVblank() returns.  The default is true.
+    void SetVblank(bool vblank);
+
+    // Draws the enabled layers, lowest index first, into the framebuffer.
+    void Render();
+
+    // Draws the enabled layers as 32-bit colors into |dest|, which is
+    // |scale| times wider and taller than the screen.  Each color holds the
+    // bytes of a Video::Color.  Pixels that no layer covers get color zero of
+    // palette zero, like in the framebuffer.
+    void RenderRGBA(uint32_t* dest, int scale,
+                    CompositeKernel kernel = COMPOSITE_KERNEL_BEST);
+
+    // Same as RenderRGBA(), but tile rows are copied from the atlas cache
+    // instead of looking up each pixel.
+    void RenderRGBACached(uint32_t* dest, int scale);
+
+    // Statistics of the atlas cache used by RenderRGBACached().
+    const TileAtlasCache::Stats& GetAtlasStats();
+
+    // The framebuffer, HOST_SCREEN_WIDTH x HOST_SCREEN_HEIGHT pixels.  Each
+    // pixel is a palette index times PALETTE_NUM_COLORS plus a color index.
+    // Pixels that no layer covers are zero.
+    const uint16_t* GetFramebuffer();
+
+    // Returns the color of a framebuffer pixel.
+    Video::Color GetColor(uint16_t pixel);
+
+    // Writes the framebuffer as a binary PPM image.
+    bool WritePPM(const char* path);
+}
+
+//  Simon Que, 2013 //
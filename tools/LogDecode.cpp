@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////////
+// LogDecode.cpp
+// - Turns the events that the game sends over serial into text.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o log_decode LogDecode.cpp ../Log.cpp
+//
+// Usage: log_decode [capture]
+//   Reads bytes captured from the serial port, from stdin by default.  Text
+//   that the game printed is passed through, and each event is printed on a
+//   line of its own.  File names are looked up by their hash in kAssetList.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include "../AssetList.h"
+#include "../Log.h"
+
+namespace {
+
+const char* const kEventNames[Log::NUM_EVENTS] = {
+    "events lost",              // EVENT_LOST
+    "file opened",              // EVENT_FILE_OPENED
+    "file not found",           // EVENT_FILE_NOT_FOUND
+    "file too big",             // EVENT_FILE_TOO_BIG
+    "bad asset pack",           // EVENT_BAD_ASSET_PACK
+    "could not read asset pack",// EVENT_ASSET_PACK_READ_FAILED
+    "state stack full",         // EVENT_STATE_STACK_FULL
+    "state stack empty",        // EVENT_STATE_STACK_EMPTY
+    "screen write dropped",     // EVENT_WRITE_QUEUE_FULL
+};
+
+// Returns the file name with the given hash, or NULL if it is not known.
+const char* findName(uint16_t hash) {
+    if (Log::HashName(ASSET_PACK_FILENAME) == hash)
+        return ASSET_PACK_FILENAME;
+    for (size_t i = 0; i < NUM_ASSETS; ++i) {
+        if (Log::HashName(kAssetList[i].filename) == hash)
+            return kAssetList[i].filename;
+    }
+    return NULL;
+}
+
+void printName(uint16_t hash) {
+    const char* name = findName(hash);
+    if (name)
+        printf(" %s", name);
+    else
+        printf(" <file %04x>", hash);
+}
+
+void printEvent(uint8_t event, const uint16_t* args, int num_args) {
+    if (event < Log::NUM_EVENTS)
+        printf("[%s]", kEventNames[event]);
+    else
+        printf("[event %u]", event);
+
+    switch (event) {
+    case Log::EVENT_FILE_OPENED:
+    case Log::EVENT_FILE_NOT_FOUND:
+    case Log::EVENT_FILE_TOO_BIG:
+        if (num_args < 1)
+            break;
+        printName(args[0]);
+        if (num_args >= 2)
+            printf(" is 0x%x bytes", args[1]);
+        if (num_args >= 3)
+            printf(", max 0x%x", args[2]);
+        printf("\n");
+        return;
+    }
+    for (int i = 0; i < num_args; ++i)
+        printf(" %u", args[i]);
+    printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    FILE* input = stdin;
+    if (argc > 1) {
+        input = fopen(argv[1], "rb");
+        if (!input) {
+            fprintf(stderr, "Could not open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    bool at_line_start = true;
+    int c;
+    while ((c = fgetc(input)) != EOF) {
+        if (!(c & LOG_HEADER_FLAG)) {
+            putchar(c);
+            at_line_start = (c == '\n');
+            continue;
+        }
+
+        uint8_t event = c & LOG_EVENT_MASK;
+        int num_args = (c >> LOG_NUM_ARGS_SHIFT) & LOG_NUM_ARGS_MASK;
+        uint16_t args[LOG_MAX_ARGS];
+        int num_read = 0;
+        for (; num_read < num_args; ++num_read) {
+            int low = fgetc(input);
+            int high = (low == EOF) ? EOF : fgetc(input);
+            if (high == EOF)
+                break;
+            args[num_read] = low | (high << 8);
+        }
+
+        // Events may arrive in the middle of a line of text.
+        if (!at_line_start)
+            printf("\n");
+        printEvent(event, args, num_read);
+        at_line_start = true;
+        if (num_read < num_args) {
+            fprintf(stderr, "Capture ends in the middle of an event\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////////////
+// OpeningBook.cpp
+// - Implements functions for classes OpeningBook and OpeningBookBuilder.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "OpeningBook.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace {
+
+// Used to fold the block type into the board hash.
+const uint64_t kTypeHashMultiplier = 0x9e3779b97f4a7c15ULL;
+
+}  // namespace
+
+OpeningBook::OpeningBook() : m_Map(NULL),
+                             m_MapSize(0),
+                             m_Header(NULL),
+                             m_Slots(NULL) {}
+
+OpeningBook::~OpeningBook() {
+    Close();
+}
+
+bool OpeningBook::Open(const char* path) {
+    Close();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    const Header* header = static_cast<const Header*>(map);
+    uint32_t num_slots = header->num_slots;
+    if (header->magic != OPENING_BOOK_MAGIC ||
+        header->version != OPENING_BOOK_VERSION ||
+        num_slots == 0 || (num_slots & (num_slots - 1)) != 0 ||
+        header->num_entries >= num_slots ||
+        sizeof(Header) + (size_t)num_slots * sizeof(Slot) >
+                (size_t)st.st_size) {
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    m_Map = map;
+    m_MapSize = st.st_size;
+    m_Header = header;
+    m_Slots = reinterpret_cast<const Slot*>(header + 1);
+    return true;
+}
+
+void OpeningBook::Close() {
+    if (m_Map)
+        munmap(m_Map, m_MapSize);
+    m_Map = NULL;
+    m_MapSize = 0;
+    m_Header = NULL;
+    m_Slots = NULL;
+}
+
+uint32_t OpeningBook::GetNumEntries() const {
+    return m_Header ? m_Header->num_entries : 0;
+}
+
+bool OpeningBook::Lookup(const Bitboard& board, int type,
+                         Placement* placement) const {
+    if (!m_Slots)
+        return false;
+
+    // A damaged book may have no empty slot, so at most every slot is probed.
+    uint64_t key = GetKey(board, type);
+    uint32_t mask = m_Header->num_slots - 1;
+    uint32_t index = key & mask;
+    for (uint32_t i = 0; i <= mask; ++i, index = (index + 1) & mask) {
+        const Slot& slot = m_Slots[index];
+        if (slot.key == key) {
+            *placement = slot.placement;
+            return true;
+        }
+        if (slot.key == 0)
+            return false;
+    }
+    return false;
+}
+
+uint64_t OpeningBook::GetKey(const Bitboard& board, int type) {
+    uint64_t key = board.Hash() ^ (type * kTypeHashMultiplier);
+    return key ? key : 1;
+}
+
+void OpeningBookBuilder::Add(const Bitboard& board, int type,
+                             const Placement& placement) {
+    m_Entries[OpeningBook::GetKey(board, type)] = placement;
+}
+
+bool OpeningBookBuilder::Contains(const Bitboard& board, int type) const {
+    return m_Entries.count(OpeningBook::GetKey(board, type)) != 0;
+}
+
+bool OpeningBookBuilder::Write(const char* path, float max_load) const {
+    // Written this way so that NaN is rejected too.
+    if (!(max_load > 0 && max_load < 1))
+        return false;
+
+    uint32_t num_slots = 1;
+    while (num_slots * max_load < m_Entries.size() + 1)
+        num_slots *= 2;
+
+    std::vector<OpeningBook::Slot> slots(num_slots);
+    memset(&slots[0], 0, num_slots * sizeof(slots[0]));
+    for (std::unordered_map<uint64_t, Placement>::const_iterator it =
+                 m_Entries.begin(); it != m_Entries.end(); ++it) {
+        uint32_t index = it->first & (num_slots - 1);
+        while (slots[index].key != 0)
+            index = (index + 1) & (num_slots - 1);
+        slots[index].key = it->first;
+        slots[index].placement = it->second;
+    }
+
+    OpeningBook::Header header;
+    header.magic = OPENING_BOOK_MAGIC;
+    header.version = OPENING_BOOK_VERSION;
+    header.num_slots = num_slots;
+    header.num_entries = m_Entries.size();
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(&slots[0], sizeof(slots[0]), num_slots, file) == num_slots;
+    return fclose(file) == 0 && ok;
+}
+
+//  Simon Que, 2013 //
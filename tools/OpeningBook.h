@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////
+// OpeningBook.h
+// - Read-only on-disk table of precomputed placements, keyed by board hash.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+
+#include "../Bitboard.h"
+
+// File layout: an OpeningBook::Header followed by |num_slots| Slots.  The
+// slots form an open-addressed table with linear probing; a key of zero marks
+// an empty slot.  All values are little-endian.
+#define OPENING_BOOK_MAGIC      0x424f4246   // "FBOB"
+#define OPENING_BOOK_VERSION    1
+
+class OpeningBook {
+  public:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t num_slots;     // Power of two.
+        uint32_t num_entries;
+    };
+
+    struct Slot {
+        uint64_t key;
+        Placement placement;
+        uint32_t unused;
+    };
+
+    OpeningBook();
+    ~OpeningBook();
+
+    // Maps the book at |path|.  Returns false if it cannot be read or is not
+    // a valid book.
+    bool Open(const char* path);
+    void Close();
+
+    bool IsOpen() const { return m_Slots != NULL; }
+    uint32_t GetNumEntries() const;
+
+    // Looks up the placement of a block of |type| on |board|.
+    bool Lookup(const Bitboard& board, int type, Placement* placement) const;
+
+    // Key of a board and block type.  Never zero.
+    static uint64_t GetKey(const Bitboard& board, int type);
+
+  private:
+    void* m_Map;
+    size_t m_MapSize;
+    const Header* m_Header;
+    const Slot* m_Slots;
+};
+
+// Collects placements in memory and writes them out as an opening book.
+class OpeningBookBuilder {
+  public:
+    // Adds or replaces the placement of a block of |type| on |board|.
+    void Add(const Bitboard& board, int type, const Placement& placement);
+
+    bool Contains(const Bitboard& board, int type) const;
+    size_t GetNumEntries() const { return m_Entries.size(); }
+
+    // Writes the book with the table at most |max_load| full.  Returns false
+    // if |max_load| is not between 0 and 1, or if the file cannot be written.
+    bool Write(const char* path, float max_load = 0.5f) const;
+
+  private:
+    std::unordered_map<uint64_t, Placement> m_Entries;
+};
+
+//  Simon Que, 2013 //
@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////////////
+// OpeningBookGen.cpp
+// - Builds an opening book offline by playing simulated games.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o opening_book_gen OpeningBookGen.cpp OpeningBook.cpp
+//       PlacementSearch.cpp TranspositionTable.cpp BoardEval.cpp Trace.cpp
+//       ../Bitboard.cpp
+//
+// Usage: opening_book_gen <output> [num_games] [num_opening_blocks] [trace]
+//   If a trace file is given, the searches are traced and written to it in
+//   the Chrome trace event format.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "OpeningBook.h"
+#include "PlacementSearch.h"
+#include "Trace.h"
+
+namespace {
+
+const int kDefaultNumGames = 100000;
+const int kDefaultNumOpeningBlocks = 8;
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output> [num_games] [num_opening_blocks] "
+                "[trace]\n", argv[0]);
+        return 1;
+    }
+    const char* output_path = argv[1];
+    int num_games = (argc > 2) ? atoi(argv[2]) : kDefaultNumGames;
+    int num_blocks = (argc > 3) ? atoi(argv[3]) : kDefaultNumOpeningBlocks;
+    const char* trace_path = (argc > 4) ? argv[4] : NULL;
+    if (trace_path)
+        Trace::Start();
+
+    // Record the searched placement of each opening position reached, so the
+    // book gives the same answers as the search, without the search.
+    OpeningBookBuilder builder;
+    PlacementSearch search;
+    srand(1);
+    for (int game = 0; game < num_games; ++game) {
+        Bitboard board;
+        board.Clear();
+        for (int block = 0; block < num_blocks; ++block) {
+            int type = rand() % NUM_BLOCK_TYPES + 1;
+            Placement placement;
+            if (!search.FindBest(board, type, &placement))
+                break;
+            builder.Add(board, type, placement);
+            board.DropBlock(placement.type, placement.rotation, placement.x);
+            board.ClearFullRows();
+        }
+    }
+
+    if (trace_path) {
+        Trace::Stop();
+        if (!Trace::WriteJson(trace_path)) {
+            fprintf(stderr, "Could not write %s\n", trace_path);
+            return 1;
+        }
+        if (Trace::GetNumDropped()) {
+            printf("Trace is full, %llu events left out\n",
+                   (unsigned long long)Trace::GetNumDropped());
+        }
+    }
+
+    if (!builder.Write(output_path)) {
+        fprintf(stderr, "Could not write %s\n", output_path);
+        return 1;
+    }
+    printf("Wrote %u positions to %s\n", (unsigned)builder.GetNumEntries(),
+           output_path);
+    return 0;
+}
+
+//  Simon Que, 2013 //
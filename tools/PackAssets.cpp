@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////////////////
+// PackAssets.cpp
+// - Builds the asset archive that the game loads at startup.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o pack_assets PackAssets.cpp AssetLz.cpp
+//
+// Usage: pack_assets <output> [data_dir]
+//   Packs the assets in kAssetList from data_dir, which is ../Data by default.
+//   Assets that are missing are left out, like the game does when it loads
+//   them one by one.  Assets are compressed where that saves enough to pay
+//   for decompressing them.  Images are placed in VRAM to use as few banks
+//   as possible, and the offset of each is listed.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../AssetList.h"
+#include "../Video.h"
+#include "AssetLz.h"
+
+namespace {
+
+// A compressed asset is read into the MCU and written out to the core, while
+// an uncompressed one is copied straight from the file by the coprocessor.
+// Reading the SD card is several times slower than the bus, so the compressed
+// data must be this much smaller to be worth it.
+const int kMinSavingsPercent = 40;
+
+// Image data offsets are 16 bits, so images can use this many VRAM banks.
+const int kNumImageBanks = IMAGE_VRAM_SIZE / IMAGE_BANK_SIZE;
+
+struct PackedAsset {
+    Assets::PackEntry entry;
+    std::vector<uint8_t> data;      // As stored.
+};
+
+// Compresses an asset if that is worth it.  Returns false if the compressed
+// data does not decompress to the original.
+bool compress(const Assets::Info& info, PackedAsset* asset) {
+    const std::vector<uint8_t>& raw = asset->data;
+    asset->entry.compression = Assets::COMPRESSION_NONE;
+    asset->entry.stored_size = raw.size();
+
+    // Palettes are written a color at a time.
+    if (info.type == Assets::TYPE_PALETTE &&
+        raw.size() % sizeof(Video::Color) != 0) {
+        return true;
+    }
+
+    std::vector<uint8_t> compressed = CompressLz(raw.data(), raw.size());
+    if (compressed.size() * 100 > raw.size() * (100 - kMinSavingsPercent))
+        return true;
+
+    std::vector<uint8_t> check;
+    if (!DecompressLz(compressed.data(), compressed.size(), raw.size(),
+                      &check) || check != raw) {
+        return false;
+    }
+    asset->entry.compression = Assets::COMPRESSION_LZ;
+    asset->entry.stored_size = compressed.size();
+    asset->data.swap(compressed);
+    return true;
+}
+
+// FNV-1a hash of the uncompressed data, which the game compares with what it
+// loaded before a reset.
+uint32_t getHash(const std::vector<uint8_t>& data) {
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < data.size(); ++i)
+        hash = (hash ^ data[i]) * 16777619U;
+    return hash;
+}
+
+bool isLargerImage(const PackedAsset* a, const PackedAsset* b) {
+    return a->entry.size > b->entry.size;
+}
+
+// Space for images in |bank|.  The last one ends at IMAGE_VRAM_END.
+uint32_t getBankSize(int bank) {
+    uint32_t begin = bank * IMAGE_BANK_SIZE;
+    if (begin + IMAGE_BANK_SIZE > IMAGE_VRAM_END)
+        return IMAGE_VRAM_END - begin;
+    return IMAGE_BANK_SIZE;
+}
+
+// Places the images in VRAM banks, largest first, each in the fullest bank
+// that it still fits in.  This fills the ends of banks that placing them in
+// load order would skip.  Returns the number of banks used, or zero if the
+// images do not fit.
+int placeImages(std::vector<PackedAsset>* assets) {
+    std::vector<PackedAsset*> images;
+    for (size_t i = 0; i < assets->size(); ++i) {
+        if ((*assets)[i].entry.type == Assets::TYPE_IMAGE)
+            images.push_back(&(*assets)[i]);
+    }
+    std::stable_sort(images.begin(), images.end(), isLargerImage);
+
+    uint32_t bank_used[kNumImageBanks] = { 0 };
+    int num_banks = 0;
+    for (size_t i = 0; i < images.size(); ++i) {
+        Assets::PackEntry& entry = images[i]->entry;
+        int best = -1;
+        for (int bank = 0; bank < kNumImageBanks; ++bank) {
+            if (bank_used[bank] + entry.size > getBankSize(bank))
+                continue;
+            if (best < 0 || bank_used[bank] > bank_used[best])
+                best = bank;
+        }
+        if (best < 0) {
+            fprintf(stderr, "Out of VRAM at %s\n", entry.name);
+            return 0;
+        }
+        entry.vram_offset = best * IMAGE_BANK_SIZE + bank_used[best];
+        bank_used[best] += entry.size;
+        if (best >= num_banks)
+            num_banks = best + 1;
+    }
+    return num_banks;
+}
+
+bool readFile(const char* path, std::vector<uint8_t>* data) {
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data->resize(size > 0 ? size : 0);
+    size_t num_read = fread(data->data(), 1, data->size(), file);
+    fclose(file);
+    return num_read == data->size();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output> [data_dir]\n", argv[0]);
+        return 1;
+    }
+    const char* output_path = argv[1];
+    const char* data_dir = (argc > 2) ? argv[2] : "../Data";
+
+    std::vector<PackedAsset> assets;
+    uint32_t raw_size = 0;
+    for (size_t i = 0; i < NUM_ASSETS; ++i) {
+        const Assets::Info& info = kAssetList[i];
+        if (strlen(info.filename) > ASSET_NAME_SIZE) {
+            fprintf(stderr, "Name %s is too long\n", info.filename);
+            return 1;
+        }
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s", data_dir, info.filename);
+        PackedAsset asset;
+        if (!readFile(path, &asset.data)) {
+            printf("Could not open file %s, leaving it out.\n", path);
+            continue;
+        }
+        uint32_t size = asset.data.size();
+        if (size > 0xffff || (info.type == Assets::TYPE_IMAGE &&
+                              size > IMAGE_BANK_SIZE)) {
+            fprintf(stderr, "File %s is too big!\n", path);
+            return 1;
+        }
+
+        memset(&asset.entry, 0, sizeof(asset.entry));
+        memcpy(asset.entry.name, info.filename, strlen(info.filename));
+        asset.entry.type = info.type;
+        asset.entry.index = info.index;
+        asset.entry.size = size;
+        asset.entry.hash = getHash(asset.data);
+
+        if (!compress(info, &asset)) {
+            fprintf(stderr, "Could not compress %s\n", path);
+            return 1;
+        }
+        raw_size += size;
+        assets.push_back(asset);
+    }
+    if (assets.size() > ASSET_PACK_MAX_ENTRIES) {
+        fprintf(stderr, "Too many assets\n");
+        return 1;
+    }
+    int num_banks = placeImages(&assets);
+    if (!num_banks)
+        return 1;
+
+    Assets::PackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, ASSET_PACK_MAGIC_SIZE);
+    header.num_entries = assets.size();
+    header.version = ASSET_PACK_VERSION;
+
+    FILE* output = fopen(output_path, "wb");
+    if (!output) {
+        fprintf(stderr, "Could not write %s\n", output_path);
+        return 1;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, output) == 1;
+    for (size_t i = 0; i < assets.size(); ++i)
+        ok &= fwrite(&assets[i].entry, sizeof(assets[i].entry), 1, output) == 1;
+    uint32_t stored_size = 0;
+    for (size_t i = 0; i < assets.size(); ++i) {
+        const std::vector<uint8_t>& data = assets[i].data;
+        ok &= fwrite(data.data(), 1, data.size(), output) == data.size();
+        stored_size += data.size();
+    }
+    ok &= fclose(output) == 0;
+    if (!ok) {
+        fprintf(stderr, "Could not write %s\n", output_path);
+        return 1;
+    }
+
+    printf("Packed %u assets into %s\n", (unsigned)assets.size(),
+           output_path);
+    uint32_t vram_used = 0;
+    for (size_t i = 0; i < assets.size(); ++i) {
+        const Assets::PackEntry& entry = assets[i].entry;
+        if (entry.type != Assets::TYPE_IMAGE)
+            continue;
+        printf("  image %u  %-12.12s  bank %u  offset 0x%04x  size 0x%04x\n",
+               entry.index, entry.name, entry.vram_offset / IMAGE_BANK_SIZE,
+               entry.vram_offset, entry.size);
+        vram_used += entry.size;
+    }
+    printf("0x%x bytes of VRAM used in %d of %d banks\n", (unsigned)vram_used,
+           num_banks, kNumImageBanks);
+    printf("%u bytes of data stored in %u bytes\n", (unsigned)raw_size,
+           (unsigned)stored_size);
+    return 0;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////////
+// PlacementSearch.cpp
+// - Implements functions for class PlacementSearch.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "PlacementSearch.h"
+
+#include "OpeningBook.h"
+#include "Trace.h"
+#include "TranspositionTable.h"
+
+namespace {
+
+// Commonly used weights for a one-ply search.
+const PlacementSearch::Weights kDefaultWeights = {
+    -0.510066f,     // aggregate_height
+     0.760666f,     // lines
+    -0.35663f,      // holes
+    -0.184483f,     // bumpiness
+};
+
+// Score of a position where the next block cannot be placed.
+const float kLostScore = -1e9f;
+
+}  // namespace
+
+PlacementSearch::PlacementSearch() : m_Weights(kDefaultWeights),
+                                     m_Book(NULL),
+                                     m_Table(NULL),
+                                     m_NumBookHits(0) {}
+
+bool PlacementSearch::FindBest(const Bitboard& board, int type,
+                               Placement* best) {
+    TRACE_SCOPE("search", "search");
+    if (m_Book && m_Book->Lookup(board, type, best)) {
+        ++m_NumBookHits;
+        return true;
+    }
+
+    float score;
+    return SearchOneBlock(board, type, best, &score);
+}
+
+bool PlacementSearch::FindBest(const Bitboard& board, int type, int next_type,
+                               Placement* best) {
+    TRACE_SCOPE("search", "search ahead");
+    TranspositionTable::Result result;
+    uint64_t key = TranspositionTable::MakeKey(board, type, next_type);
+    if (m_Table && m_Table->Probe(key, 2, &result)) {
+        *best = result.best;
+        return true;
+    }
+
+    Candidates& root = m_Candidates[1];
+    BuildCandidates(board, type, &root);
+    if (root.num_candidates == 0)
+        return false;
+
+    // Score each placement by the best placement of the next block after it.
+    // The same board is often reached from more than one move, and again on
+    // the following move, so these results go through the table.
+    int best_index = 0;
+    float best_score = 0;
+    for (int i = 0; i < root.num_candidates; ++i) {
+        TranspositionTable::Result next;
+        uint64_t next_key = TranspositionTable::MakeKey(root.boards[i],
+                                                        next_type, NO_BLOCK);
+        if (!m_Table || !m_Table->Probe(next_key, 1, &next)) {
+            next.depth = 1;
+            if (!SearchOneBlock(root.boards[i], next_type, &next.best,
+                                &next.score)) {
+                next.score = kLostScore;
+                next.best.type = NO_BLOCK;
+            }
+            if (m_Table)
+                m_Table->Store(next_key, next);
+        }
+
+        float score = next.score + m_Weights.lines * root.lines[i];
+        if (i == 0 || score > best_score) {
+            best_score = score;
+            best_index = i;
+        }
+    }
+
+    *best = root.placements[best_index];
+    if (m_Table) {
+        result.score = best_score;
+        result.depth = 2;
+        result.best = *best;
+        m_Table->Store(key, result);
+    }
+    return true;
+}
+
+void PlacementSearch::BuildCandidates(const Bitboard& board, int type,
+                                      Candidates* candidates) {
+    int count = 0;
+    for (int rotation = 0; rotation < GetNumRotations(type); ++rotation) {
+        const BlockShape& shape = GetBlockShape(type, rotation);
+        for (int x = 0; x + shape.width <= SQUARES_PER_ROW; ++x) {
+            Bitboard& next = candidates->boards[count];
+            next = board;
+            int y = next.DropBlock(type, rotation, x);
+            if (y < 0)
+                continue;
+
+            Placement& placement = candidates->placements[count];
+            placement.type = type;
+            placement.rotation = rotation;
+            placement.x = x;
+            placement.y = y;
+            candidates->lines[count] = next.ClearFullRows();
+            ++count;
+        }
+    }
+    candidates->num_candidates = count;
+}
+
+bool PlacementSearch::SearchOneBlock(const Bitboard& board, int type,
+                                     Placement* best, float* best_score) {
+    Candidates& candidates = m_Candidates[0];
+    BuildCandidates(board, type, &candidates);
+    if (candidates.num_candidates == 0)
+        return false;
+
+    EvaluateBoards(candidates.boards, candidates.num_candidates,
+                   candidates.features);
+
+    int best_index = 0;
+    *best_score = Score(candidates.features[0], candidates.lines[0]);
+    for (int i = 1; i < candidates.num_candidates; ++i) {
+        float score = Score(candidates.features[i], candidates.lines[i]);
+        if (score > *best_score) {
+            *best_score = score;
+            best_index = i;
+        }
+    }
+    *best = candidates.placements[best_index];
+    return true;
+}
+
+float PlacementSearch::Score(const BoardFeatures& features, int lines) const {
+    return m_Weights.aggregate_height * features.aggregate_height +
+           m_Weights.lines * lines +
+           m_Weights.holes * features.holes +
+           m_Weights.bumpiness * features.bumpiness;
+}
+
+//  Simon Que, 2013 //
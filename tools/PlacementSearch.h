@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////////////
+// PlacementSearch.h
+// - Picks where to drop a block by scoring every possible placement.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../Bitboard.h"
+#include "BoardEval.h"
+
+class OpeningBook;
+class TranspositionTable;
+
+// Every orientation at every column.
+#define MAX_PLACEMENTS    (NUM_ROTATIONS * SQUARES_PER_ROW)
+
+// Placement search.  All candidate boards of a block are built first and then
+// scored in one EvaluateBoards() call.  If an opening book is set, it is
+// consulted before searching one block.  If a transposition table is set,
+// searches that look at the next block store and reuse their results in it.
+// The table may be shared by searches running on other threads.
+class PlacementSearch {
+  public:
+    // Weights of the score of a board.  Higher scores are better.
+    struct Weights {
+        float aggregate_height;
+        float lines;
+        float holes;
+        float bumpiness;
+    };
+
+    PlacementSearch();
+
+    void SetWeights(const Weights& weights) { m_Weights = weights; }
+
+    // |book| must stay open while it is set.  Pass NULL to stop using it.
+    void SetOpeningBook(const OpeningBook* book) { m_Book = book; }
+
+    // |table| must outlive this object or be unset.  Pass NULL to stop using
+    // it.
+    void SetTranspositionTable(TranspositionTable* table) { m_Table = table; }
+
+    // Finds the best placement of a block of |type| on |board|.  Returns false
+    // if the block cannot be placed anywhere.
+    bool FindBest(const Bitboard& board, int type, Placement* best);
+
+    // Same, but scores each placement by the best placement of a block of
+    // |next_type| that can follow it.
+    bool FindBest(const Bitboard& board, int type, int next_type,
+                  Placement* best);
+
+    // Number of FindBest() calls answered by the opening book.
+    uint32_t GetNumBookHits() const { return m_NumBookHits; }
+
+  private:
+    // The boards after each placement of one block.
+    struct Candidates {
+        int num_candidates;
+        Bitboard boards[MAX_PLACEMENTS];
+        Placement placements[MAX_PLACEMENTS];
+        int8_t lines[MAX_PLACEMENTS];
+        BoardFeatures features[MAX_PLACEMENTS];
+    };
+
+    static void BuildCandidates(const Bitboard& board, int type,
+                                Candidates* candidates);
+
+    // Scores every placement of one block.  Returns false if there are none.
+    bool SearchOneBlock(const Bitboard& board, int type, Placement* best,
+                        float* best_score);
+
+    float Score(const BoardFeatures& features, int lines) const;
+
+    Weights m_Weights;
+    const OpeningBook* m_Book;
+    TranspositionTable* m_Table;
+    uint32_t m_NumBookHits;
+
+    // Candidates of the last block searched, and of the first block when
+    // looking ahead.
+    Candidates m_Candidates[2];
+};
+
+//  Simon Que, 2013 //
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////////
+// ScreenRender.cpp
+// - Draws a game screen with Screen on the host and saves it as an image.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o screen_render ScreenRender.cpp HostVideo.cpp TileAtlas.cpp
+//       TileComposite.cpp ../Screen.cpp ../Assets.cpp ../Hud.cpp ../cBlock.cpp
+//       ../cSquare.cpp ../LandedSquares.cpp ../Log.cpp Trace.cpp
+//
+// Usage: screen_render <output.ppm> [num_renders] [trace]
+//
+// The image can be compared against a known good one to catch rendering
+// changes.  num_renders sets how many times the frame is composited, to
+// measure the compositing time.  If a trace file is given, the renders are
+// traced and written to it in the Chrome trace event format.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "../Hud.h"
+#include "../Screen.h"
+#include "../LandedSquares.h"
+#include "../cBlock.h"
+#include "HostVideo.h"
+#include "Trace.h"
+
+namespace {
+
+const int kDefaultNumRenders = 100;
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output.ppm> [num_renders] [trace]\n",
+                argv[0]);
+        return 1;
+    }
+    int num_renders = (argc > 2) ? atoi(argv[2]) : kDefaultNumRenders;
+    const char* trace_path = (argc > 3) ? argv[3] : NULL;
+
+    // Draw one frame of a game in progress, as Game() does.
+    Screen screen;
+    screen.Init();
+    screen.FinishLoading();
+    Hud hud;
+
+    cBlock focus(BLOCK_START_X * SQUARE_SIZE, BLOCK_START_Y * SQUARE_SIZE,
+                 T_BLOCK);
+    cBlock next(NEXT_BLOCK_CIRCLE_X * SQUARE_SIZE,
+                NEXT_BLOCK_CIRCLE_Y * SQUARE_SIZE, STRAIGHT_BLOCK);
+    LandedSquares landed;
+    for (int x = GAME_AREA_LEFT; x < GAME_AREA_RIGHT - 1; ++x) {
+        landed.Add(cSquare(x * SQUARE_SIZE + SQUARE_MEDIAN,
+                           (GAME_AREA_BOTTOM - 1) * SQUARE_SIZE + SQUARE_MEDIAN,
+                           x % 7 + 1));
+    }
+    screen.DrawBackground(2);
+    screen.DrawBlocks(&landed, 0, &focus, &next);
+    hud.Draw(&screen, 2, 8400, 2 * POINTS_PER_LEVEL);
+    screen.Update();
+    screen.PollFlip();
+
+    if (trace_path)
+        Trace::Start();
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    for (int i = 0; i < num_renders; ++i)
+        HostVideo::Render();
+    double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    Trace::Stop();
+    printf("%d renders in %.3f s, %.1f us per frame\n",
+           num_renders, seconds, seconds * 1e6 / num_renders);
+
+    if (!HostVideo::WritePPM(argv[1])) {
+        fprintf(stderr, "Could not write %s\n", argv[1]);
+        return 1;
+    }
+    if (trace_path && !Trace::WriteJson(trace_path)) {
+        fprintf(stderr, "Could not write %s\n", trace_path);
+        return 1;
+    }
+    if (Trace::GetNumDropped()) {
+        printf("Trace is full, %llu events left out\n",
+               (unsigned long long)Trace::GetNumDropped());
+    }
+    return 0;
+}
+
+//  Simon Que, 2013 //
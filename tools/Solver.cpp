@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Solver.cpp
+// - Implements functions for class Solver.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Solver.h"
+
+#include <string.h>
+
+#include "../cBlock.h"
+#include "Trace.h"
+
+namespace {
+
+// Columns with even and odd indexes.  Every full row has as many squares in
+// even columns as in odd columns, and clearing rows does not move squares
+// between columns, so the difference between the two counts has to be evened
+// out by the remaining blocks before the board can be empty.
+const RowMask kEvenColumns = 0x5555 & FULL_ROW_MASK;
+const RowMask kOddColumns  = 0xaaaa & FULL_ROW_MASK;
+
+// Used to fold the queue position into the board hash.
+const uint64_t kDepthHashMultiplier = 0x9e3779b97f4a7c15ULL;
+
+int ColumnParity(RowMask mask) {
+    return CountBits(mask & kEvenColumns) - CountBits(mask & kOddColumns);
+}
+
+// Largest change in column parity that one block of |type| can make.
+int MaxParityChange(int type) {
+    int max_change = 0;
+    for (int rotation = 0; rotation < GetNumRotations(type); ++rotation) {
+        const BlockShape& shape = GetBlockShape(type, rotation);
+        int change = 0;
+        for (int i = 0; i < shape.height; ++i)
+            change += ColumnParity(shape.rows[i]);
+        if (change < 0)
+            change = -change;
+        if (change > max_change)
+            max_change = change;
+    }
+    return max_change;
+}
+
+}  // namespace
+
+Solver::Solver() : m_Generation(0), m_QueueLength(0), m_NodesSearched(0) {
+    memset(m_Memo, 0, sizeof(m_Memo));
+}
+
+bool Solver::Solve(const Bitboard& board, const uint8_t* queue,
+                   int queue_length, Goal goal, Result* result) {
+    TRACE_SCOPE("search", "solve");
+    if (queue_length > SOLVER_MAX_QUEUE_LENGTH)
+        queue_length = SOLVER_MAX_QUEUE_LENGTH;
+
+    // Start a new generation instead of clearing the memo table.
+    if (++m_Generation == 0) {
+        memset(m_Memo, 0, sizeof(m_Memo));
+        m_Generation = 1;
+    }
+
+    memcpy(m_Queue, queue, queue_length);
+    m_QueueLength = queue_length;
+    m_ParityBudget[queue_length] = 0;
+    for (int i = queue_length - 1; i >= 0; --i)
+        m_ParityBudget[i] = m_ParityBudget[i + 1] + MaxParityChange(queue[i]);
+    m_NodesSearched = 0;
+
+    result->perfect_clear = false;
+    result->lines_cleared = 0;
+    result->num_placements = 0;
+
+    if (goal == PERFECT_CLEAR) {
+        if (board.Empty()) {
+            result->perfect_clear = true;
+            return true;
+        }
+        if (!SearchPerfectClear(board, 0))
+            return false;
+
+        // Replay the path to fill in the result.
+        Bitboard temp_board = board;
+        for (int depth = 0; !temp_board.Empty(); ++depth) {
+            const Placement& placement = m_Path[depth];
+            result->lines_cleared += Place(&temp_board, placement.type,
+                                           placement.rotation, placement.x,
+                                           &result->placements[depth]);
+            ++result->num_placements;
+        }
+        result->perfect_clear = true;
+        return true;
+    }
+
+    // Follow the best move of each position.  These are in the memo table
+    // unless they have been replaced, in which case they are searched again.
+    Bitboard temp_board = board;
+    for (int depth = 0; depth < queue_length; ++depth) {
+        Placement best;
+        SearchMaxLines(temp_board, depth, &best);
+        if (best.type == NO_BLOCK)
+            break;
+        result->lines_cleared += Place(&temp_board, best.type, best.rotation,
+                                       best.x, &result->placements[depth]);
+        ++result->num_placements;
+    }
+    result->perfect_clear = temp_board.Empty();
+    return true;
+}
+
+int Solver::Place(Bitboard* board, int type, int rotation, int x,
+                  Placement* placement) {
+    int y = board->DropBlock(type, rotation, x);
+    if (y < 0)
+        return -1;
+
+    placement->type = type;
+    placement->rotation = rotation;
+    placement->x = x;
+    placement->y = y;
+
+    return board->ClearFullRows();
+}
+
+bool Solver::CanPerfectClear(const Bitboard& board, int depth) const {
+    int remaining = m_QueueLength - depth;
+    int num_squares = board.CountSquares();
+
+    // The squares left after some number of blocks must fill whole rows.
+    int num_blocks = 1;
+    while (num_blocks <= remaining &&
+           (num_squares + num_blocks * CBLOCK_NUM_SQUARES) % SQUARES_PER_ROW != 0) {
+        ++num_blocks;
+    }
+    if (num_blocks > remaining)
+        return false;
+
+    // Every occupied row has to be cleared, which takes at least one full row
+    // of squares each.
+    int height = MAX_NUM_LINES;
+    while (height > 0 && !board.rows[height - 1])
+        --height;
+    if (height * SQUARES_PER_ROW > num_squares + remaining * CBLOCK_NUM_SQUARES)
+        return false;
+
+    int parity = 0;
+    for (int y = 0; y < height; ++y)
+        parity += ColumnParity(board.rows[y]);
+    if (parity < 0)
+        parity = -parity;
+    return parity <= m_ParityBudget[depth];
+}
+
+bool Solver::SearchPerfectClear(const Bitboard& board, int depth) {
+    ++m_NodesSearched;
+
+    if (depth == m_QueueLength || !CanPerfectClear(board, depth))
+        return false;
+
+    MemoEntry* entry = Lookup(board, depth);
+    if (entry->generation == m_Generation)
+        return false;   // Only failures are stored.
+
+    int type = m_Queue[depth];
+    for (int rotation = 0; rotation < GetNumRotations(type); ++rotation) {
+        const BlockShape& shape = GetBlockShape(type, rotation);
+        for (int x = 0; x + shape.width <= SQUARES_PER_ROW; ++x) {
+            Bitboard next = board;
+            if (Place(&next, type, rotation, x, &m_Path[depth]) < 0)
+                continue;
+            if (next.Empty() || SearchPerfectClear(next, depth + 1))
+                return true;
+        }
+    }
+
+    // The entry may have been replaced during the search.
+    entry = Lookup(board, depth);
+    entry->generation = m_Generation;
+    entry->value = -1;
+    return false;
+}
+
+int Solver::SearchMaxLines(const Bitboard& board, int depth, Placement* best) {
+    ++m_NodesSearched;
+
+    best->type = NO_BLOCK;
+    if (depth == m_QueueLength)
+        return 0;
+
+    MemoEntry* entry = Lookup(board, depth);
+    if (entry->generation == m_Generation) {
+        *best = entry->best;
+        return entry->value;
+    }
+
+    int best_lines = 0;
+    int type = m_Queue[depth];
+    for (int rotation = 0; rotation < GetNumRotations(type); ++rotation) {
+        const BlockShape& shape = GetBlockShape(type, rotation);
+        for (int x = 0; x + shape.width <= SQUARES_PER_ROW; ++x) {
+            Bitboard next = board;
+            Placement placement;
+            int lines = Place(&next, type, rotation, x, &placement);
+            if (lines < 0)
+                continue;
+
+            Placement next_best;
+            lines += SearchMaxLines(next, depth + 1, &next_best);
+            if (best->type == NO_BLOCK || lines > best_lines) {
+                best_lines = lines;
+                *best = placement;
+            }
+        }
+    }
+
+    entry = Lookup(board, depth);
+    entry->generation = m_Generation;
+    entry->value = best_lines;
+    entry->best = *best;
+    return best_lines;
+}
+
+Solver::MemoEntry* Solver::Lookup(const Bitboard& board, int depth) {
+    uint64_t key = board.Hash() ^ ((depth + 1) * kDepthHashMultiplier);
+    MemoEntry* entry = &m_Memo[key >> (64 - SOLVER_MEMO_BITS)];
+    if (entry->key != key) {
+        entry->key = key;
+        entry->generation = 0;
+    }
+    return entry;
+}
+
+//  Simon Que, 2013 //
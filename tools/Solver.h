@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Solver.h
+// - Searches for block placements that clear the board, for offline analysis.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../Bitboard.h"
+
+// Longest piece queue the solver accepts.
+#define SOLVER_MAX_QUEUE_LENGTH    16
+
+// The memo table has 2^SOLVER_MEMO_BITS entries.
+#define SOLVER_MEMO_BITS           16
+#define SOLVER_MEMO_SIZE           (1 << SOLVER_MEMO_BITS)
+
+// Depth-first search over the placements of a known piece queue.  Blocks are
+// dropped straight down from the top of the game area in each orientation.
+//
+// All search state lives inside the object, including the memo table, so a
+// Solver does no allocation of its own.  It is large; create one per thread
+// and reuse it across positions.
+class Solver {
+  public:
+    enum Goal {
+        PERFECT_CLEAR,  // Find a sequence that leaves the board empty.
+        MAX_LINES,      // Find the sequence that clears the most lines.
+    };
+
+    struct Result {
+        bool perfect_clear;     // The board is empty after the placements.
+        int lines_cleared;
+        int num_placements;
+        Placement placements[SOLVER_MAX_QUEUE_LENGTH];
+    };
+
+    Solver();
+
+    // Searches |board| with the pieces in |queue|, which are BlockType values
+    // placed in order.  Returns false if |goal| is PERFECT_CLEAR and no
+    // sequence empties the board, true otherwise.
+    bool Solve(const Bitboard& board, const uint8_t* queue, int queue_length,
+               Goal goal, Result* result);
+
+    // Number of positions visited by the last call to Solve().
+    uint32_t GetNodesSearched() const { return m_NodesSearched; }
+
+  private:
+    struct MemoEntry {
+        uint64_t key;
+        uint32_t generation;    // Entry is valid if this matches m_Generation.
+        int8_t value;           // Best number of lines, or -1 for no clear.
+        Placement best;
+    };
+
+    // Drop shape |rotation| of |type| at column |x|.  Returns the number of
+    // lines cleared, or -1 if the block does not fit.
+    static int Place(Bitboard* board, int type, int rotation, int x,
+                     Placement* placement);
+
+    // Returns true if a perfect clear is still possible from |board| with the
+    // pieces from |depth| onwards.
+    bool CanPerfectClear(const Bitboard& board, int depth) const;
+
+    bool SearchPerfectClear(const Bitboard& board, int depth);
+    int SearchMaxLines(const Bitboard& board, int depth, Placement* best);
+
+    MemoEntry* Lookup(const Bitboard& board, int depth);
+
+    MemoEntry m_Memo[SOLVER_MEMO_SIZE];
+    uint32_t m_Generation;
+
+    // Queue of the current search.
+    uint8_t m_Queue[SOLVER_MAX_QUEUE_LENGTH];
+    int m_QueueLength;
+
+    // Sum of the largest column parity change of the pieces from each index
+    // onwards.
+    int m_ParityBudget[SOLVER_MAX_QUEUE_LENGTH + 1];
+
+    Placement m_Path[SOLVER_MAX_QUEUE_LENGTH];
+    uint32_t m_NodesSearched;
+};
+
+//  Simon Que, 2013 //
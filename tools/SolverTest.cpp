@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////////
+// SolverTest.cpp
+// - Checks Solver against fill puzzles with known answers.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -o solver_test SolverTest.cpp Solver.cpp Trace.cpp ../Bitboard.cpp
+//
+// Exits with status 1 if any puzzle gets the wrong answer.  The unsolvable
+// puzzles must be rejected by the pruning at the root, without searching any
+// placements, so that the pruning itself is checked.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include "Solver.h"
+
+namespace {
+
+struct Puzzle {
+    const char* name;
+    RowMask rows[4];            // Bottom-up.  Rows above these are empty.
+    uint8_t queue[SOLVER_MAX_QUEUE_LENGTH];
+    int queue_length;
+    Solver::Goal goal;
+
+    bool solvable;
+    int lines_cleared;
+    int num_placements;
+    bool pruned_at_root;        // Rejected without trying any placement.
+};
+
+const Puzzle kPuzzles[] = {
+    { "empty board", { 0 }, { SQUARE_BLOCK }, 1, Solver::PERFECT_CLEAR,
+      true, 0, 0, false },
+    { "row with a four gap", { 0x3f0 }, { STRAIGHT_BLOCK }, 1,
+      Solver::PERFECT_CLEAR, true, 1, 1, false },
+    { "two rows with a square gap", { 0x0ff, 0x0ff }, { SQUARE_BLOCK }, 1,
+      Solver::PERFECT_CLEAR, true, 2, 1, false },
+    { "two rows of squares", { 0x003, 0x003 },
+      { SQUARE_BLOCK, SQUARE_BLOCK, SQUARE_BLOCK, SQUARE_BLOCK }, 4,
+      Solver::PERFECT_CLEAR, true, 2, 4, false },
+    { "gap needs the straight block last", { 0x3f0 },
+      { SQUARE_BLOCK, STRAIGHT_BLOCK }, 2, Solver::PERFECT_CLEAR,
+      false, 0, 0, false },
+
+    // 1 + 4 and 1 + 8 squares never fill whole rows.
+    { "squares not divisible", { 0x001 }, { SQUARE_BLOCK, SQUARE_BLOCK }, 2,
+      Solver::PERFECT_CLEAR, false, 0, 0, true },
+    // Six squares fill a row with one more block, but five are in even
+    // columns and one in an odd column.  A square block covers as many even
+    // columns as odd ones, so it cannot even them out.
+    { "column parity", { 0x255 }, { SQUARE_BLOCK }, 1, Solver::PERFECT_CLEAR,
+      false, 0, 0, true },
+    // Three occupied rows need 30 squares, and there are only 6 + 4.
+    { "too high", { 0x003, 0x003, 0x003 }, { SQUARE_BLOCK }, 1,
+      Solver::PERFECT_CLEAR, false, 0, 0, true },
+
+    { "most lines from four squares", { 0 },
+      { SQUARE_BLOCK, SQUARE_BLOCK, SQUARE_BLOCK, SQUARE_BLOCK }, 4,
+      Solver::MAX_LINES, true, 0, 4, false },
+    { "most lines from a nearly full row", { 0x3f0, 0x3f0 },
+      { STRAIGHT_BLOCK, STRAIGHT_BLOCK }, 2, Solver::MAX_LINES,
+      true, 2, 2, false },
+};
+
+const int kNumPuzzles = sizeof(kPuzzles) / sizeof(kPuzzles[0]);
+
+// Replays the placements of |result| on |board|, and checks that each one is
+// where the block lands and that the lines and final board match.
+bool checkReplay(Bitboard board, const Solver::Result& result) {
+    int lines = 0;
+    for (int i = 0; i < result.num_placements; ++i) {
+        const Placement& placement = result.placements[i];
+        int y = board.DropBlock(placement.type, placement.rotation,
+                                placement.x);
+        if (y != placement.y)
+            return false;
+        lines += board.ClearFullRows();
+    }
+    return lines == result.lines_cleared &&
+           board.Empty() == result.perfect_clear;
+}
+
+}  // namespace
+
+int main() {
+    static Solver solver;
+    int num_failed = 0;
+    for (int i = 0; i < kNumPuzzles; ++i) {
+        const Puzzle& puzzle = kPuzzles[i];
+        Bitboard board;
+        board.Clear();
+        for (int y = 0; y < 4; ++y)
+            board.rows[y] = puzzle.rows[y];
+
+        Solver::Result result;
+        bool solved = solver.Solve(board, puzzle.queue, puzzle.queue_length,
+                                   puzzle.goal, &result);
+        bool ok = solved == puzzle.solvable;
+        if (ok && solved) {
+            ok = result.lines_cleared == puzzle.lines_cleared &&
+                 result.num_placements == puzzle.num_placements &&
+                 checkReplay(board, result);
+            if (puzzle.goal == Solver::PERFECT_CLEAR)
+                ok &= result.perfect_clear;
+        }
+        if (puzzle.pruned_at_root)
+            ok &= solver.GetNodesSearched() == 1;
+
+        printf("%-36s %s, %d lines, %d placements, %u nodes\n", puzzle.name,
+               ok ? "ok" : "FAILED", result.lines_cleared,
+               result.num_placements, solver.GetNodesSearched());
+        if (!ok)
+            ++num_failed;
+    }
+    if (num_failed) {
+        printf("%d of %d puzzles failed\n", num_failed, kNumPuzzles);
+        return 1;
+    }
+    return 0;
+}
+
+//  Simon Que, 2013 //
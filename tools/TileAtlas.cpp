@@ -0,0 +1,166 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TileAtlas.cpp
+// - Implements functions for class TileAtlasCache.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "TileAtlas.h"
+
+#include <string.h>
+
+#include "Trace.h"
+
+namespace {
+
+uint32_t getColorValue(const Video::Color& color) {
+    uint32_t value;
+    memcpy(&value, &color, sizeof(value));
+    return value;
+}
+
+}  // namespace
+
+TileAtlasCache::TileAtlasCache(const uint8_t* vram,
+                               const Video::Color* palettes)
+        : m_VRAM(vram), m_Palettes(palettes), m_LastAtlas(-1) {
+    memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+void TileAtlasCache::AddImage(uint32_t vram_offset, uint32_t size) {
+    m_Images.push_back(Image());
+    Image& image = m_Images.back();
+    image.vram_offset = vram_offset;
+    image.size = size;
+    IndexImage(&image);
+}
+
+void TileAtlasCache::Clear() {
+    m_Images.clear();
+    m_Atlases.clear();
+    m_LastAtlas = -1;
+}
+
+void TileAtlasCache::OnPaletteEntryChanged(int palette, int index) {
+    for (size_t i = 0; i < m_Atlases.size(); ++i) {
+        Atlas& atlas = m_Atlases[i];
+        if (atlas.palette != palette)
+            continue;
+        atlas.dirty[index / 8] |= (1 << (index % 8));
+        atlas.any_dirty = true;
+    }
+}
+
+void TileAtlasCache::OnPaletteChanged(int palette) {
+    for (size_t i = 0; i < m_Atlases.size(); ++i) {
+        Atlas& atlas = m_Atlases[i];
+        if (atlas.palette != palette)
+            continue;
+        memset(atlas.dirty, 0xff, sizeof(atlas.dirty));
+        atlas.any_dirty = true;
+    }
+}
+
+const uint32_t* TileAtlasCache::Lookup(uint32_t vram_offset, int size,
+                                       int palette) {
+    // Consecutive lookups are usually from the same tileset.
+    if (m_LastAtlas >= 0) {
+        Atlas& atlas = m_Atlases[m_LastAtlas];
+        const Image& image = m_Images[atlas.image];
+        if (atlas.palette == palette && !atlas.any_dirty &&
+            vram_offset >= image.vram_offset &&
+            vram_offset + size <= image.vram_offset + image.size) {
+            return &atlas.colors[vram_offset - image.vram_offset];
+        }
+    }
+
+    int image_index = -1;
+    for (size_t i = 0; i < m_Images.size(); ++i) {
+        const Image& image = m_Images[i];
+        if (vram_offset >= image.vram_offset &&
+            vram_offset + size <= image.vram_offset + image.size) {
+            image_index = i;
+            break;
+        }
+    }
+    if (image_index < 0)
+        return NULL;
+
+    m_LastAtlas = -1;
+    for (size_t i = 0; i < m_Atlases.size(); ++i) {
+        if (m_Atlases[i].image == image_index &&
+            m_Atlases[i].palette == palette) {
+            m_LastAtlas = i;
+            break;
+        }
+    }
+
+    Atlas* atlas;
+    if (m_LastAtlas >= 0) {
+        atlas = &m_Atlases[m_LastAtlas];
+        if (atlas->any_dirty)
+            Refresh(atlas);
+    } else {
+        m_LastAtlas = m_Atlases.size();
+        m_Atlases.push_back(Atlas());
+        atlas = &m_Atlases.back();
+        atlas->image = image_index;
+        atlas->palette = palette;
+        Build(atlas);
+    }
+    return &atlas->colors[vram_offset - m_Images[image_index].vram_offset];
+}
+
+void TileAtlasCache::IndexImage(Image* image) const {
+    const uint8_t* pixels = m_VRAM + image->vram_offset;
+
+    // Count the pixels of each color, then place them.
+    image->color_start.assign(PALETTE_NUM_COLORS + 1, 0);
+    for (uint32_t i = 0; i < image->size; ++i)
+        ++image->color_start[pixels[i] + 1];
+    for (int c = 0; c < PALETTE_NUM_COLORS; ++c)
+        image->color_start[c + 1] += image->color_start[c];
+
+    std::vector<uint32_t> next(image->color_start.begin(),
+                               image->color_start.end() - 1);
+    image->positions.resize(image->size);
+    for (uint32_t i = 0; i < image->size; ++i)
+        image->positions[next[pixels[i]]++] = i;
+}
+
+void TileAtlasCache::Build(Atlas* atlas) {
+    TRACE_SCOPE("render", "tile build");
+    const Image& image = m_Images[atlas->image];
+    const uint8_t* pixels = m_VRAM + image.vram_offset;
+    const Video::Color* palette =
+            m_Palettes + atlas->palette * PALETTE_NUM_COLORS;
+
+    atlas->colors.resize(image.size);
+    for (uint32_t i = 0; i < image.size; ++i)
+        atlas->colors[i] = getColorValue(palette[pixels[i]]);
+    memset(atlas->dirty, 0, sizeof(atlas->dirty));
+    atlas->any_dirty = false;
+    ++m_Stats.builds;
+}
+
+void TileAtlasCache::Refresh(Atlas* atlas) {
+    TRACE_SCOPE("render", "tile flush");
+    const Image& image = m_Images[atlas->image];
+    const Video::Color* palette =
+            m_Palettes + atlas->palette * PALETTE_NUM_COLORS;
+
+    for (int c = 0; c < PALETTE_NUM_COLORS; ++c) {
+        if (!(atlas->dirty[c / 8] & (1 << (c % 8))))
+            continue;
+        uint32_t value = getColorValue(palette[c]);
+        for (uint32_t i = image.color_start[c];
+             i < image.color_start[c + 1]; ++i) {
+            atlas->colors[image.positions[i]] = value;
+        }
+        m_Stats.refreshed_pixels +=
+                image.color_start[c + 1] - image.color_start[c];
+    }
+    memset(atlas->dirty, 0, sizeof(atlas->dirty));
+    atlas->any_dirty = false;
+    ++m_Stats.refreshes;
+}
+
+//  Simon Que, 2013 //
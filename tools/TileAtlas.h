@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TileAtlas.h
+// - Cache of tile images with their palette colors already looked up.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "../Video.h"
+
+// Holds a copy of each image in VRAM as 32-bit colors, one copy per palette it
+// is drawn with, so a tile row can be copied out without palette lookups.
+// Copies are made the first time they are looked up.  When a palette color
+// changes, only the pixels of that color are updated, the next time the copy
+// is looked up.
+class TileAtlasCache {
+  public:
+    struct Stats {
+        uint32_t builds;            // Copies made from scratch.
+        uint32_t refreshes;         // Copies updated after palette changes.
+        uint64_t refreshed_pixels;
+    };
+
+    // |vram| and |palettes| are read whenever a copy is made or updated.
+    TileAtlasCache(const uint8_t* vram, const Video::Color* palettes);
+
+    // Registers an image loaded into VRAM.
+    void AddImage(uint32_t vram_offset, uint32_t size);
+
+    // Drops all images and copies.
+    void Clear();
+
+    // Call these after palette colors change.
+    void OnPaletteEntryChanged(int palette, int index);
+    void OnPaletteChanged(int palette);
+
+    // Returns the colors of the |size| VRAM bytes at |vram_offset|, as looked
+    // up in |palette|.  Returns NULL if the range is not inside one image.
+    const uint32_t* Lookup(uint32_t vram_offset, int size, int palette);
+
+    const Stats& GetStats() const { return m_Stats; }
+
+  private:
+    struct Image {
+        uint32_t vram_offset;
+        uint32_t size;
+
+        // Pixel positions grouped by color index: the pixels of color c are
+        // positions[color_start[c]] up to positions[color_start[c + 1]].
+        std::vector<uint32_t> color_start;
+        std::vector<uint32_t> positions;
+    };
+
+    struct Atlas {
+        int image;
+        int palette;
+        std::vector<uint32_t> colors;
+        uint8_t dirty[PALETTE_NUM_COLORS / 8];  // One bit per color index.
+        bool any_dirty;
+    };
+
+    void IndexImage(Image* image) const;
+    void Build(Atlas* atlas);
+    void Refresh(Atlas* atlas);
+
+    const uint8_t* m_VRAM;
+    const Video::Color* m_Palettes;
+    std::vector<Image> m_Images;
+    std::vector<Atlas> m_Atlases;
+    int m_LastAtlas;        // Index of the atlas of the last lookup, or -1.
+    Stats m_Stats;
+};
+
+//  Simon Que, 2013 //
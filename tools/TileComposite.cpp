@@ -0,0 +1,164 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TileComposite.cpp
+// - Implements the scanline compositing kernels.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "TileComposite.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+// All kernels go over one layer at a time, so the scanline stays in cache:
+// - A pixel is drawn if it is covered and, when the layer has a color key,
+//   its color index differs from the key.
+// - Drawn pixels are replaced by the palette color of their index.  There is
+//   no partial blending.
+
+namespace {
+
+int CompositeScalar(const ScanlineLayer& layer, int begin, int width,
+                    uint32_t* dest) {
+    for (int x = begin; x < width; ++x) {
+        uint8_t color = layer.colors[x];
+        if (!layer.covered[x])
+            continue;
+        if (layer.use_color_key && color == layer.color_key)
+            continue;
+        dest[x] = layer.palette[color];
+    }
+    return width - begin;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// The SSE2 kernel finds which of 16 pixels are drawn with byte compares.  SSE2
+// has no gather, so the palette lookups are done one at a time, and the drawn
+// mask is widened to select between the old and new colors.
+__attribute__((target("sse2")))
+int CompositeSse2(const ScanlineLayer& layer, int width, uint32_t* dest) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i key = _mm_set1_epi8(layer.color_key);
+    const __m128i all = _mm_set1_epi8(-1);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i colors = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(layer.colors + x));
+        __m128i covered = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(layer.covered + x));
+
+        // Bytes of 0xff where the pixel is drawn.
+        __m128i drawn = _mm_xor_si128(_mm_cmpeq_epi8(covered, zero), all);
+        if (layer.use_color_key)
+            drawn = _mm_andnot_si128(_mm_cmpeq_epi8(colors, key), drawn);
+
+        int drawn_bits = _mm_movemask_epi8(drawn);
+        if (drawn_bits == 0)
+            continue;
+
+        __m128i drawn_16[2] = { _mm_unpacklo_epi8(drawn, drawn),
+                                _mm_unpackhi_epi8(drawn, drawn) };
+        for (int i = 0; i < 4; ++i) {
+            if (((drawn_bits >> (i * 4)) & 0xf) == 0)
+                continue;
+
+            const uint8_t* c = layer.colors + x + i * 4;
+            __m128i values = _mm_set_epi32(layer.palette[c[3]],
+                                           layer.palette[c[2]],
+                                           layer.palette[c[1]],
+                                           layer.palette[c[0]]);
+            __m128i mask = (i % 2 == 0) ?
+                           _mm_unpacklo_epi16(drawn_16[i / 2], drawn_16[i / 2]) :
+                           _mm_unpackhi_epi16(drawn_16[i / 2], drawn_16[i / 2]);
+
+            __m128i* out = reinterpret_cast<__m128i*>(dest + x + i * 4);
+            __m128i old_values = _mm_loadu_si128(out);
+            _mm_storeu_si128(out, _mm_or_si128(_mm_and_si128(mask, values),
+                                               _mm_andnot_si128(mask,
+                                                                old_values)));
+        }
+    }
+    return x;
+}
+
+// The AVX2 kernel widens 8 color indexes to 32 bits and gathers their palette
+// colors in one instruction.
+__attribute__((target("avx2")))
+int CompositeAvx2(const ScanlineLayer& layer, int width, uint32_t* dest) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i key = _mm256_set1_epi32(layer.color_key);
+    const int* palette = reinterpret_cast<const int*>(layer.palette);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i colors = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(layer.colors + x)));
+        __m256i covered = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(layer.covered + x)));
+
+        // Lanes of all ones where the pixel is not drawn.
+        __m256i skipped = _mm256_cmpeq_epi32(covered, zero);
+        if (layer.use_color_key) {
+            skipped = _mm256_or_si256(skipped,
+                                      _mm256_cmpeq_epi32(colors, key));
+        }
+        if (_mm256_movemask_epi8(skipped) == -1)
+            continue;
+
+        __m256i values = _mm256_i32gather_epi32(palette, colors, 4);
+        __m256i* out = reinterpret_cast<__m256i*>(dest + x);
+        __m256i old_values = _mm256_loadu_si256(out);
+        _mm256_storeu_si256(out, _mm256_blendv_epi8(values, old_values,
+                                                    skipped));
+    }
+    return x;
+}
+
+#endif  // HAVE_X86_KERNELS
+
+}  // namespace
+
+bool IsCompositeKernelSupported(CompositeKernel kernel) {
+    switch (kernel) {
+    case COMPOSITE_KERNEL_BEST:
+    case COMPOSITE_KERNEL_SCALAR:
+        return true;
+#ifdef HAVE_X86_KERNELS
+    case COMPOSITE_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case COMPOSITE_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#else
+    default:
+        break;
+#endif
+    }
+    return false;
+}
+
+void CompositeScanline(const ScanlineLayer* layers, int num_layers, int width,
+                       uint32_t* dest, CompositeKernel kernel) {
+    if (kernel == COMPOSITE_KERNEL_BEST) {
+        if (IsCompositeKernelSupported(COMPOSITE_KERNEL_AVX2))
+            kernel = COMPOSITE_KERNEL_AVX2;
+        else if (IsCompositeKernelSupported(COMPOSITE_KERNEL_SSE2))
+            kernel = COMPOSITE_KERNEL_SSE2;
+        else
+            kernel = COMPOSITE_KERNEL_SCALAR;
+    }
+
+    for (int i = 0; i < num_layers; ++i) {
+        int done = 0;
+#ifdef HAVE_X86_KERNELS
+        if (kernel == COMPOSITE_KERNEL_AVX2)
+            done = CompositeAvx2(layers[i], width, dest);
+        else if (kernel == COMPOSITE_KERNEL_SSE2)
+            done = CompositeSse2(layers[i], width, dest);
+#endif
+        CompositeScalar(layers[i], done, width, dest);
+    }
+}
+
+//  Simon Que, 2013 //
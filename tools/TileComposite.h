@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TileComposite.h
+// - Blends the tile layers of one scanline into 32-bit colors.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+// One tile layer's pixels on a scanline, before palette lookup.
+struct ScanlineLayer {
+    const uint8_t* colors;      // Color index of each pixel.
+    const uint8_t* covered;     // Zero where no tile is drawn, e.g. NOP tiles.
+    const uint32_t* palette;    // The layer's 256 colors.
+    uint8_t color_key;
+    bool use_color_key;         // Pixels of |color_key| are not drawn.
+};
+
+// Implementations of CompositeScanline().  They all give the same results.
+enum CompositeKernel {
+    COMPOSITE_KERNEL_BEST,      // Fastest kernel the CPU supports.
+    COMPOSITE_KERNEL_SCALAR,
+    COMPOSITE_KERNEL_SSE2,      // 16 pixels per pass.
+    COMPOSITE_KERNEL_AVX2,      // 8 pixels per pass, with gathered lookups.
+};
+
+// Returns true if |kernel| can run on this CPU.
+bool IsCompositeKernelSupported(CompositeKernel kernel);
+
+// Draws |num_layers| layers, lowest first, over |width| pixels of |dest|.
+// Each pixel is looked up in its layer's palette, and is skipped where the
+// tile is not covered or the color key is hit.  Pixels left over after the
+// last full SIMD pass are done by the scalar kernel.
+void CompositeScanline(const ScanlineLayer* layers, int num_layers, int width,
+                       uint32_t* dest,
+                       CompositeKernel kernel = COMPOSITE_KERNEL_BEST);
+
+//  Simon Que, 2013 //
@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Trace.cpp
+// - Implements the host event trace.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "Trace.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+namespace {
+
+struct Event {
+    const char* category;
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// The events of one thread.  Only that thread writes them.  Buffers are never
+// freed, so that they can be written out after their threads have exited.
+struct ThreadBuffer {
+    std::vector<Event> events;
+    std::atomic<uint32_t> num_events;
+    std::atomic<uint64_t> num_dropped;
+    uint32_t thread_index;
+    ThreadBuffer* next;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// Clock ticks since the clock's epoch at Start().  GetTimeNs() reads this
+// from any thread, also while Start() sets it.
+std::atomic<Clock::rep> g_start_ticks(
+        Clock::now().time_since_epoch().count());
+
+// Buffers of all threads, newest first.  Threads add theirs with a
+// compare-and-swap, so that no lock is taken.
+std::atomic<ThreadBuffer*> g_buffers(NULL);
+std::atomic<uint32_t> g_num_threads(0);
+
+thread_local ThreadBuffer* t_buffer = NULL;
+
+ThreadBuffer* getThreadBuffer() {
+    if (t_buffer)
+        return t_buffer;
+    ThreadBuffer* buffer = new ThreadBuffer;
+    buffer->events.resize(TRACE_EVENTS_PER_THREAD);
+    buffer->num_events.store(0, std::memory_order_relaxed);
+    buffer->num_dropped.store(0, std::memory_order_relaxed);
+    buffer->thread_index = g_num_threads.fetch_add(1);
+    buffer->next = g_buffers.load(std::memory_order_relaxed);
+    while (!g_buffers.compare_exchange_weak(buffer->next, buffer,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+    t_buffer = buffer;
+    return buffer;
+}
+
+// Writes |text| as a JSON string.  Names are literals in the code, so only
+// quotes and backslashes are escaped.
+void writeString(FILE* file, const char* text) {
+    fputc('"', file);
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', file);
+        fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+}  // namespace
+
+namespace Trace {
+
+    std::atomic<bool> g_enabled(false);
+
+    uint64_t GetTimeNs() {
+        Clock::time_point start(
+                Clock::duration(g_start_ticks.load(std::memory_order_relaxed)));
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start).count();
+    }
+
+    void AddEvent(const char* category, const char* name, uint64_t start_ns,
+                  uint64_t duration_ns) {
+        ThreadBuffer* buffer = getThreadBuffer();
+        uint32_t index = buffer->num_events.load(std::memory_order_relaxed);
+        if (index >= buffer->events.size()) {
+            buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Event& event = buffer->events[index];
+        event.category = category;
+        event.name = name;
+        event.start_ns = start_ns;
+        event.duration_ns = duration_ns;
+        buffer->num_events.store(index + 1, std::memory_order_release);
+    }
+
+    void Start() {
+        g_enabled.store(false);
+        for (ThreadBuffer* buffer = g_buffers.load(); buffer;
+             buffer = buffer->next) {
+            buffer->num_events.store(0);
+            buffer->num_dropped.store(0);
+        }
+        g_start_ticks.store(Clock::now().time_since_epoch().count());
+        g_enabled.store(true);
+    }
+
+    void Stop() {
+        g_enabled.store(false);
+    }
+
+    bool WriteJson(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (!file)
+            return false;
+
+        // Timestamps are in microseconds.
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        for (ThreadBuffer* buffer = g_buffers.load(std::memory_order_acquire);
+             buffer; buffer = buffer->next) {
+            uint32_t num_events =
+                    buffer->num_events.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < num_events; ++i) {
+                const Event& event = buffer->events[i];
+                fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"cat\":",
+                        first ? "" : ",\n", buffer->thread_index);
+                writeString(file, event.category);
+                fprintf(file, ",\"name\":");
+                writeString(file, event.name);
+                fprintf(file, ",\"ts\":%.3f,\"dur\":%.3f}",
+                        event.start_ns / 1000.0, event.duration_ns / 1000.0);
+                first = false;
+            }
+        }
+        fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+        return fclose(file) == 0;
+    }
+
+    uint64_t GetNumDropped() {
+        uint64_t num_dropped = 0;
+        for (ThreadBuffer* buffer = g_buffers.load(); buffer;
+             buffer = buffer->next) {
+            num_dropped += buffer->num_dropped.load();
+        }
+        return num_dropped;
+    }
+
+}  // namespace Trace
+
+//  Simon Que, 2013 //
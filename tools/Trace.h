@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Trace.h
+// - Records timed events on the host and writes them in the Chrome trace event
+//   format, which chrome://tracing and Perfetto can show.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Events kept per thread.  Events past this are dropped and counted.
+#define TRACE_EVENTS_PER_THREAD    (1 << 16)
+
+#define TRACE_CONCAT_INNER(a, b)   a ## b
+#define TRACE_CONCAT(a, b)         TRACE_CONCAT_INNER(a, b)
+
+// Records the time from here to the end of the enclosing scope as an event.
+// |category| and |name| must be string literals.
+#define TRACE_SCOPE(category, name) \
+    Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(category, name)
+
+// Tracing is off until Start() is called.  While it is off, a TRACE_SCOPE only
+// loads a flag.
+//
+// Each thread writes its events to a buffer of its own, made the first time it
+// records one, so recording takes no locks.  Threads are numbered in the order
+// that they first record an event.
+namespace Trace {
+
+    extern std::atomic<bool> g_enabled;
+
+    inline bool IsEnabled() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Returns the time since Start() in nanoseconds.  This may be called from
+    // any thread at any time.
+    uint64_t GetTimeNs();
+
+    // Records an event on the calling thread.
+    void AddEvent(const char* category, const char* name, uint64_t start_ns,
+                  uint64_t duration_ns);
+
+    // Drops all recorded events and starts recording.  Call this while no
+    // thread is recording.
+    void Start();
+
+    // Stops recording.  Call this after the threads that record events have
+    // finished, or while they are not recording.
+    void Stop();
+
+    // Writes the events recorded by all threads as a JSON trace.  Returns false
+    // if the file could not be written.
+    bool WriteJson(const char* path);
+
+    // Number of events dropped because a thread's buffer was full.
+    uint64_t GetNumDropped();
+
+    class Scope {
+      public:
+        Scope(const char* category, const char* name)
+                : m_Category(category), m_Name(name),
+                  m_Start(IsEnabled() ? GetTimeNs() : kNotTiming) {}
+
+        ~Scope() {
+            if (m_Start != kNotTiming && IsEnabled())
+                AddEvent(m_Category, m_Name, m_Start, GetTimeNs() - m_Start);
+        }
+
+      private:
+        static const uint64_t kNotTiming = ~0ULL;
+
+        const char* m_Category;
+        const char* m_Name;
+        uint64_t m_Start;
+    };
+}
+
+//  Simon Que, 2013 //
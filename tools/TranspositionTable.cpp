@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TranspositionTable.cpp
+// - Implements functions for class TranspositionTable.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "TranspositionTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// Used to fold the block types into the board hash.
+const uint64_t kTypeHashMultiplier = 0x9e3779b97f4a7c15ULL;
+const uint64_t kNextTypeHashMultiplier = 0xc2b2ae3d27d4eb4fULL;
+
+// Bit layout of a packed result.
+const int kScoreShift    = 0;   // 32 bits, IEEE float.
+const int kDepthShift    = 32;  // 6 bits.
+const int kTypeShift     = 38;  // 3 bits.
+const int kRotationShift = 41;  // 2 bits.
+const int kXShift        = 43;  // 4 bits.
+const int kYShift        = 47;  // 4 bits.
+
+// Set in every packed result, so that data is never zero for a used entry.
+const uint64_t kValidBit = 1ULL << 63;
+
+}  // namespace
+
+TranspositionTable::TranspositionTable(size_t size_bytes)
+        : m_Buckets(NULL), m_NumBuckets(1) {
+    while (m_NumBuckets * 2 * sizeof(Bucket) <= size_bytes)
+        m_NumBuckets *= 2;
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, TT_CACHE_LINE_SIZE,
+                       m_NumBuckets * sizeof(Bucket)) != 0) {
+        abort();
+    }
+    m_Buckets = static_cast<Bucket*>(memory);
+    Clear();
+}
+
+TranspositionTable::~TranspositionTable() {
+    free(m_Buckets);
+}
+
+bool TranspositionTable::Probe(uint64_t key, int min_depth, Result* result) {
+    m_Counters.probes.fetch_add(1, std::memory_order_relaxed);
+
+    Bucket& bucket = m_Buckets[key & (m_NumBuckets - 1)];
+    for (int i = 0; i < kEntriesPerBucket; ++i) {
+        Entry& entry = bucket.entries[i];
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || !(data & kValidBit))
+            continue;
+
+        Unpack(data, result);
+        if (result->depth < min_depth)
+            return false;
+        m_Counters.hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t key, const Result& result) {
+    m_Counters.stores.fetch_add(1, std::memory_order_relaxed);
+
+    Bucket& bucket = m_Buckets[key & (m_NumBuckets - 1)];
+    Entry* victim = &bucket.entries[0];
+    int victim_depth = 64;
+    for (int i = 0; i < kEntriesPerBucket; ++i) {
+        Entry& entry = bucket.entries[i];
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if (!(data & kValidBit) || (check ^ data) == key) {
+            victim = &entry;
+            break;
+        }
+        int depth = (data >> kDepthShift) & 0x3f;
+        if (depth < victim_depth) {
+            victim = &entry;
+            victim_depth = depth;
+        }
+    }
+
+    uint64_t data = Pack(result);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear() {
+    for (size_t i = 0; i < m_NumBuckets; ++i) {
+        for (int j = 0; j < kEntriesPerBucket; ++j) {
+            m_Buckets[i].entries[j].check.store(0, std::memory_order_relaxed);
+            m_Buckets[i].entries[j].data.store(0, std::memory_order_relaxed);
+        }
+    }
+    m_Counters.probes.store(0, std::memory_order_relaxed);
+    m_Counters.hits.store(0, std::memory_order_relaxed);
+    m_Counters.stores.store(0, std::memory_order_relaxed);
+}
+
+TranspositionTable::Stats TranspositionTable::GetStats() const {
+    Stats stats;
+    stats.probes = m_Counters.probes.load(std::memory_order_relaxed);
+    stats.hits = m_Counters.hits.load(std::memory_order_relaxed);
+    stats.stores = m_Counters.stores.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t TranspositionTable::MakeKey(const Bitboard& board, int type,
+                                     int next_type) {
+    uint64_t key = board.Hash() ^ (type * kTypeHashMultiplier) ^
+                   (next_type * kNextTypeHashMultiplier);
+    return key ? key : 1;
+}
+
+uint64_t TranspositionTable::Pack(const Result& result) {
+    uint32_t score_bits;
+    memcpy(&score_bits, &result.score, sizeof(score_bits));
+    return kValidBit |
+           ((uint64_t)score_bits << kScoreShift) |
+           ((uint64_t)(result.depth & 0x3f) << kDepthShift) |
+           ((uint64_t)(result.best.type & 0x7) << kTypeShift) |
+           ((uint64_t)(result.best.rotation & 0x3) << kRotationShift) |
+           ((uint64_t)(result.best.x & 0xf) << kXShift) |
+           ((uint64_t)(result.best.y & 0xf) << kYShift);
+}
+
+void TranspositionTable::Unpack(uint64_t data, Result* result) {
+    uint32_t score_bits = data >> kScoreShift;
+    memcpy(&result->score, &score_bits, sizeof(score_bits));
+    result->depth = (data >> kDepthShift) & 0x3f;
+    result->best.type = (data >> kTypeShift) & 0x7;
+    result->best.rotation = (data >> kRotationShift) & 0x3;
+    result->best.x = (data >> kXShift) & 0xf;
+    result->best.y = (data >> kYShift) & 0xf;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TranspositionTable.h
+// - Fixed-size table of search results shared between search threads.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "../Bitboard.h"
+
+// Size of one bucket; buckets are aligned to it so a probe touches one line.
+#define TT_CACHE_LINE_SIZE     64
+
+// Table of search results keyed by a 64-bit position hash.  There are no
+// locks.  Each entry is stored as (key ^ data, data), so an entry torn by two
+// threads writing at once fails the key check on the next probe and reads as
+// a miss.
+class TranspositionTable {
+  public:
+    struct Result {
+        float score;
+        uint8_t depth;          // Number of blocks searched, at most 63.
+        Placement best;
+    };
+
+    struct Stats {
+        uint64_t probes;
+        uint64_t hits;
+        uint64_t stores;
+    };
+
+    // Allocates buckets worth at most |size_bytes|, rounded down to a power of
+    // two number of buckets.
+    explicit TranspositionTable(size_t size_bytes);
+    ~TranspositionTable();
+
+    size_t GetSizeBytes() const { return m_NumBuckets * sizeof(Bucket); }
+
+    // Looks up |key|.  Only results searched to at least |min_depth| count
+    // as hits.
+    bool Probe(uint64_t key, int min_depth, Result* result);
+
+    // Stores a result.  Within a bucket, an entry with the same key or else
+    // the shallowest entry is replaced.
+    void Store(uint64_t key, const Result& result);
+
+    // Empties the table and resets the statistics.
+    void Clear();
+
+    Stats GetStats() const;
+
+    // Key of a position: the board and the known block types, with NO_BLOCK
+    // for blocks that are not known.  Never zero.
+    static uint64_t MakeKey(const Bitboard& board, int type, int next_type);
+
+  private:
+    struct Entry {
+        std::atomic<uint64_t> check;    // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    enum { kEntriesPerBucket = TT_CACHE_LINE_SIZE / sizeof(Entry) };
+
+    struct alignas(TT_CACHE_LINE_SIZE) Bucket {
+        Entry entries[kEntriesPerBucket];
+    };
+
+    static uint64_t Pack(const Result& result);
+    static void Unpack(uint64_t data, Result* result);
+
+    Bucket* m_Buckets;
+    size_t m_NumBuckets;    // Power of two.
+
+    // Statistics are only approximately consistent with each other.  They
+    // are kept on their own cache line, away from the buckets pointer.
+    struct alignas(TT_CACHE_LINE_SIZE) Counters {
+        std::atomic<uint64_t> probes;
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> stores;
+    };
+    Counters m_Counters;
+
+    TranspositionTable(const TranspositionTable&);
+    TranspositionTable& operator=(const TranspositionTable&);
+
+    // Writes torn entries to check that they are rejected.
+    friend class TranspositionTableTest;
+};
+
+//  Simon Que, 2013 //
@@ -0,0 +1,212 @@
+//////////////////////////////////////////////////////////////////////////////////
+// TranspositionTableTest.cpp
+// - Checks that TranspositionTable returns what was stored, also while
+//   several threads store into the same bucket.
+//
+// Build on the host from the tools directory:
+//   g++ -O2 -pthread -o transposition_table_test TranspositionTableTest.cpp
+//       TranspositionTable.cpp ../Bitboard.cpp
+//
+// A torn entry has the key check of one store and the data of another.  Torn
+// entries are first written directly, which checks that they read as misses
+// on any machine.  Then threads store into a table of one bucket while others
+// probe it, which tears entries for real when the threads run at once.  Every
+// result is made from its key and the thread that stored it, so a hit that
+// returns anything else is caught.  Exits with status 1 if any check fails.
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "TranspositionTable.h"
+
+// Writes entries the way two racing stores can leave them.
+class TranspositionTableTest {
+  public:
+    // Stores |first| for |key|, and then replaces only its data with that of
+    // |second|, as if another thread's store of |second| got halfway.
+    static void StoreTorn(TranspositionTable* table, uint64_t key,
+                          const TranspositionTable::Result& first,
+                          const TranspositionTable::Result& second) {
+        table->Store(key, first);
+        TranspositionTable::Entry* entry = FindEntry(table, key, first);
+        entry->data.store(TranspositionTable::Pack(second));
+    }
+
+    // Stores |result| for |key|, and then replaces only its check with the
+    // one of |other_result| stored for |other_key|.
+    static void StoreTornCheck(TranspositionTable* table, uint64_t key,
+                               const TranspositionTable::Result& result,
+                               uint64_t other_key,
+                               const TranspositionTable::Result& other_result) {
+        table->Store(key, result);
+        TranspositionTable::Entry* entry = FindEntry(table, key, result);
+        entry->check.store(other_key ^
+                           TranspositionTable::Pack(other_result));
+    }
+
+  private:
+    // Finds the entry by its data, so that this does not depend on how the
+    // check is made.  The test stores each result once.
+    static TranspositionTable::Entry* FindEntry(
+            TranspositionTable* table, uint64_t key,
+            const TranspositionTable::Result& result) {
+        TranspositionTable::Bucket& bucket =
+                table->m_Buckets[key & (table->m_NumBuckets - 1)];
+        for (int i = 0; i < TranspositionTable::kEntriesPerBucket; ++i) {
+            TranspositionTable::Entry& entry = bucket.entries[i];
+            if (entry.data.load() == TranspositionTable::Pack(result))
+                return &entry;
+        }
+        abort();
+    }
+};
+
+namespace {
+
+const int kNumWriters = 4;
+const int kNumReaders = 4;
+const int kNumIterations = 1000000;
+
+// Few enough keys that readers often probe one that is stored.
+const uint64_t kNumKeys = 8;
+
+uint64_t getKey(uint64_t index) {
+    return (index + 1) * 0x9e3779b97f4a7c15ULL;
+}
+
+// The result that |writer| stores for key |index|.  The fields of the
+// placement are within the bits that the table keeps.
+TranspositionTable::Result makeResult(uint64_t index, int writer) {
+    TranspositionTable::Result result;
+    result.score = index * 16 + writer;
+    result.depth = writer + 1;
+    result.best.type = index % NUM_BLOCK_TYPES + 1;
+    result.best.rotation = writer % NUM_ROTATIONS;
+    result.best.x = index % SQUARES_PER_ROW;
+    result.best.y = writer;
+    return result;
+}
+
+bool sameResult(const TranspositionTable::Result& a,
+                const TranspositionTable::Result& b) {
+    return a.score == b.score && a.depth == b.depth &&
+           a.best.type == b.best.type && a.best.rotation == b.best.rotation &&
+           a.best.x == b.best.x && a.best.y == b.best.y;
+}
+
+// Returns true if |result| is one that some writer stored for key |index|.
+bool isStoredResult(uint64_t index, const TranspositionTable::Result& result) {
+    int writer = (int)result.score - (int)(index * 16);
+    return writer >= 0 && writer < kNumWriters &&
+           sameResult(result, makeResult(index, writer));
+}
+
+// Stores and probes from one thread.
+bool checkSingleThread() {
+    TranspositionTable table(1 << 16);
+    for (uint64_t i = 0; i < kNumKeys; ++i)
+        table.Store(getKey(i), makeResult(i, 2));
+
+    for (uint64_t i = 0; i < kNumKeys; ++i) {
+        TranspositionTable::Result result;
+        if (!table.Probe(getKey(i), 3, &result) ||
+            !sameResult(result, makeResult(i, 2))) {
+            printf("key %d: stored result not found\n", (int)i);
+            return false;
+        }
+        if (table.Probe(getKey(i), 4, &result)) {
+            printf("key %d: hit deeper than stored\n", (int)i);
+            return false;
+        }
+    }
+
+    TranspositionTable::Result result;
+    if (table.Probe(getKey(kNumKeys), 0, &result)) {
+        printf("hit on a key that was not stored\n");
+        return false;
+    }
+    return true;
+}
+
+// Torn entries written directly must read as misses.
+bool checkTornEntries() {
+    TranspositionTable table(1 << 16);
+    TranspositionTable::Result result;
+    for (uint64_t i = 0; i < kNumKeys; ++i) {
+        TranspositionTableTest::StoreTorn(&table, getKey(i), makeResult(i, 0),
+                                          makeResult(i, 1));
+        if (table.Probe(getKey(i), 0, &result)) {
+            printf("key %d: hit on an entry with torn data\n", (int)i);
+            return false;
+        }
+
+        // The check of a store of another key, which this key's slot may
+        // be getting.
+        uint64_t other = (i + 1) % kNumKeys;
+        TranspositionTableTest::StoreTornCheck(&table, getKey(i),
+                                               makeResult(i, 0),
+                                               getKey(other),
+                                               makeResult(other, 1));
+        if (table.Probe(getKey(i), 0, &result) ||
+            table.Probe(getKey(other), 0, &result)) {
+            printf("key %d: hit on an entry with a torn check\n", (int)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writers and readers share one bucket.
+bool checkThreads() {
+    TranspositionTable table(1);
+    std::atomic<uint64_t> num_wrong(0);
+    std::atomic<uint64_t> num_hits(0);
+
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < kNumWriters; ++writer) {
+        threads.push_back(std::thread([&table, writer]() {
+            for (int i = 0; i < kNumIterations; ++i) {
+                uint64_t index = (i * 7 + writer) % kNumKeys;
+                table.Store(getKey(index), makeResult(index, writer));
+            }
+        }));
+    }
+    for (int reader = 0; reader < kNumReaders; ++reader) {
+        threads.push_back(std::thread([&table, &num_wrong, &num_hits,
+                                       reader]() {
+            uint64_t hits = 0;
+            for (int i = 0; i < kNumIterations; ++i) {
+                uint64_t index = (i * 5 + reader) % kNumKeys;
+                TranspositionTable::Result result;
+                if (!table.Probe(getKey(index), 0, &result))
+                    continue;
+                ++hits;
+                if (!isStoredResult(index, result))
+                    num_wrong.fetch_add(1);
+            }
+            num_hits.fetch_add(hits);
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    printf("%d readers, %d writers: %llu hits, %llu wrong\n", kNumReaders,
+           kNumWriters, (unsigned long long)num_hits.load(),
+           (unsigned long long)num_wrong.load());
+    return num_wrong.load() == 0 && num_hits.load() > 0;
+}
+
+}  // namespace
+
+int main() {
+    if (!checkSingleThread() || !checkTornEntries() || !checkThreads())
+        return 1;
+    return 0;
+}
+
+//  Simon Que, 2013 //
@@ -0,0 +1,29 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Arduino.h
+// - Host stand-in for the Arduino core functions that the game uses.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Time is simulated by tools/CoreSim.cpp.  It only advances on bus
+// transactions, delay() and calls to millis() and micros().
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// printf() already goes to stdout on the host.  Bytes written to Serial go to
+// the file set with CoreSim::SetSerialOutput(), and are dropped by default.
+// Nothing is ever received.
+class HardwareSerial {
+  public:
+    void begin(uint32_t baud) {}
+    size_t write(const uint8_t* data, size_t size);
+    int read() { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+//  Simon Que, 2013 //
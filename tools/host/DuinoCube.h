@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////////
+// DuinoCube.h
+// - Host stand-in for the DuinoCube library, backed by tools/CoreSim.cpp.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+// Add tools/host to the include path to build Video.cpp and System.cpp on the
+// host.  Only the parts of the library that the game uses are here.  See
+// CoreSim.h for the memory model and the bus accounting.
+
+// Main registers.
+#define REG_MEM_BANK                0x00
+#define REG_SYS_CTRL                0x02
+#define REG_OUTPUT_STATUS           0x04
+
+#define REG_SYS_CTRL_VRAM_ACCESS       0    // Let the MCU access VRAM.
+#define REG_VBLANK                     0
+
+// Tile layer registers.
+#define TILE_LAYER_REG_BASE        0x100
+#define TILE_LAYER_REG_SIZE         0x40
+#define TILE_LAYER_REG(layer, reg) \
+    (TILE_LAYER_REG_BASE + (layer) * TILE_LAYER_REG_SIZE + (reg))
+
+#define TILE_CTRL_0                 0x00
+#define TILE_DATA_OFFSET            0x02
+#define TILE_EMPTY_VALUE            0x04
+#define TILE_COLOR_KEY              0x06
+#define TILE_OFFSET_X               0x08
+#define TILE_OFFSET_Y               0x0a
+
+// Bits of TILE_CTRL_0.
+#define TILE_LAYER_ENABLED             0
+#define TILE_ENABLE_NOP                1
+#define TILE_ENABLE_8x8                2
+#define TILE_ENABLE_8_BIT              3
+#define TILE_ENABLE_TRANSP             4
+#define TILE_PALETTE_START             8
+
+// Palettes are not banked.
+#define PALETTE_BASE              0x4000
+#define PALETTE_SIZE               0x400
+#define PALETTE(index)            (PALETTE_BASE + (index) * PALETTE_SIZE)
+#define PALETTE_ENTRY(index, entry)   (PALETTE(index) + (entry) * 4)
+
+// The upper half of the address space is a window onto the bank selected by
+// REG_MEM_BANK.
+#define BANKED_MEM_BASE           0x8000
+#define BANKED_MEM_SIZE           0x8000
+
+#define TILEMAP_BANK                   1
+#define TILEMAP_SIZE               0x800
+#define TILEMAP(layer)            (BANKED_MEM_BASE + (layer) * TILEMAP_SIZE)
+
+#define VRAM_BASE                 BANKED_MEM_BASE
+#define VRAM_BANK_SIZE            BANKED_MEM_SIZE
+#define VRAM_BANK_BEGIN                8
+#define VRAM_NUM_BANKS                 2
+
+// File modes.
+#define FILE_READ_ONLY                 0
+
+// Gamepad buttons.
+#define GAMEPAD_BUTTON_1               0
+#define GAMEPAD_BUTTON_2               1
+#define GAMEPAD_BUTTON_3               2
+#define GAMEPAD_BUTTON_4               3
+
+struct GamepadState {
+    uint16_t buttons;
+    int16_t x, y;
+};
+
+class DuinoCubeCore {
+  public:
+    uint16_t readWord(uint16_t addr);
+    void writeWord(uint16_t addr, uint16_t value);
+    void readData(uint16_t addr, void* data, uint16_t size);
+    void writeData(uint16_t addr, const void* data, uint16_t size);
+};
+
+class DuinoCubeFile {
+  public:
+    // Returns a handle, or zero if the file could not be opened.
+    uint16_t open(const char* path, uint16_t mode);
+    void close(uint16_t handle);
+    uint16_t size(uint16_t handle);
+
+    // Both read from the current position of the file and advance it.  They
+    // return the number of bytes read.
+    uint16_t read(uint16_t handle, void* data, uint16_t size);
+    uint16_t readToCore(uint16_t handle, uint16_t addr, uint16_t size);
+};
+
+class DuinoCubeGamepad {
+  public:
+    GamepadState readGamepad();
+};
+
+class DuinoCube {
+  public:
+    void begin();
+
+    DuinoCubeCore Core;
+    DuinoCubeFile File;
+    DuinoCubeGamepad Gamepad;
+};
+
+extern DuinoCube DC;
+
+//  Simon Que, 2013 //
@@ -0,0 +1,9 @@
+//////////////////////////////////////////////////////////////////////////////////
+// SPI.h
+// - Host stand-in for the Arduino SPI library.  The bus is simulated by
+//   tools/CoreSim.cpp, so there is nothing here.
+//////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//  Simon Que, 2013 //